@@ -0,0 +1,51 @@
+//##############################################################################
+//! @file
+//! @author Brandon Kentel
+//!
+//! A single thread for running low priority work off the main thread.
+//##############################################################################
+#pragma once
+
+#include <functional>
+#include <memory>
+
+////////////////////////////////////////////////////////////////////////////////
+namespace bkrl {
+////////////////////////////////////////////////////////////////////////////////
+
+namespace detail { class background_worker_impl; }
+
+//==============================================================================
+//! Runs posted tasks, in order, on a thread of its own.
+//!
+//! Nothing is shared between the caller and a task implicitly; whatever a
+//! task touches must be left alone by the caller until a call to sync.
+//==============================================================================
+class background_worker {
+public:
+    using task = std::function<void ()>;
+
+    background_worker();
+    ~background_worker();
+
+    background_worker(background_worker const&)            = delete;
+    background_worker& operator=(background_worker const&) = delete;
+
+    //! Queue @p t to be run after every task posted before it.
+    void post(task t);
+
+    //! True if every task posted so far has finished.
+    bool is_idle() const;
+
+    //--------------------------------------------------------------------------
+    //! Block until every task posted so far has finished.
+    //! @pre not called from within a task.
+    //--------------------------------------------------------------------------
+    void sync();
+private:
+    std::unique_ptr<detail::background_worker_impl> impl_;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+} //namespace bkrl
+////////////////////////////////////////////////////////////////////////////////
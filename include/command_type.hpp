@@ -45,12 +45,15 @@ enum class command_type : uint16_t {
   , open
   , close
   , get
+  , get_all
   , drop
   , inventory
   , wield_wear
   , take_off
   , equipment
 
+  , debug_stats
+
   , enum_size //!< last
 };
 
@@ -23,6 +23,15 @@ public:
     float              zoom_min      = 0.1f;
     float              zoom_max      = 5.0f;
     float              auto_scroll_w = 0.1f;
+
+    //! entities within sim_radius_full of the player act every turn, those
+    //! within sim_radius_coarse once every sim_interval turns; the rest are
+    //! frozen until the player comes back into range. Entities only change
+    //! tier when they act, so sim_radius_full should leave some slack beyond
+    //! the distance at which entities notice the player.
+    int                sim_radius_full   = 15;
+    int                sim_radius_coarse = 40;
+    int                sim_interval      = 5;
 };
 
 config load_config(json::cref data);
@@ -0,0 +1,106 @@
+//##############################################################################
+//! @file
+//! @author Brandon Kentel
+//!
+//! Contiguous storage for definitions keyed by a hashed id.
+//##############################################################################
+#pragma once
+
+#include <vector>
+#include <boost/container/flat_map.hpp>
+
+#include "assert.hpp"
+#include "identifier.hpp"
+#include "optional.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+namespace bkrl {
+////////////////////////////////////////////////////////////////////////////////
+
+//==============================================================================
+//! Definitions stored in load order, each identified by both its (sparse)
+//! hashed id and a dense index into the table.
+//!
+//! Indices are assigned as definitions are inserted and never change, so
+//! instances can hold on to them and resolve their definition by indexing an
+//! array; the id is only needed to find the index in the first place.
+//==============================================================================
+template <typename Id, typename Index, typename T>
+class definition_table {
+public:
+    using id_type    = Id;
+    using index_type = Index;
+    using value_type = T;
+
+    //--------------------------------------------------------------------------
+    //! Append @p value as the definition for @p id.
+    //! @returns the index assigned to @p id, or nothing if @p id is already
+    //!          defined.
+    //--------------------------------------------------------------------------
+    optional<index_type> insert(id_type const id, value_type&& value) {
+        using value_t = typename index_type::value_type;
+
+        auto const n = values_.size();
+        BK_ASSERT(n < static_cast<size_t>(invalid_index));
+
+        auto const index  = index_type {static_cast<value_t>(n)};
+        auto const result = indices_.emplace(id, index);
+        if (!result.second) {
+            return {};
+        }
+
+        values_.push_back(std::move(value));
+
+        return index;
+    }
+
+    void reserve(size_t const n) {
+        values_.reserve(n);
+        indices_.reserve(n);
+    }
+
+    //--------------------------------------------------------------------------
+    //! @returns the index of @p id, or nothing if it isn't defined.
+    //--------------------------------------------------------------------------
+    optional<index_type> find(id_type const id) const {
+        auto const it = indices_.find(id);
+        if (it == std::end(indices_)) {
+            return {};
+        }
+
+        return it->second;
+    }
+
+    bool is_valid(index_type const index) const noexcept {
+        return id_to_value(index) < values_.size();
+    }
+
+    value_type const& operator[](index_type const index) const {
+        BK_ASSERT_DBG(is_valid(index));
+        return values_[id_to_value(index)];
+    }
+
+    value_type& operator[](index_type const index) {
+        BK_ASSERT_DBG(is_valid(index));
+        return values_[id_to_value(index)];
+    }
+
+    int size() const noexcept { return static_cast<int>(values_.size()); }
+
+    auto begin() const noexcept { return values_.begin(); }
+    auto end()   const noexcept { return values_.end(); }
+
+    auto begin() noexcept { return values_.begin(); }
+    auto end()   noexcept { return values_.end(); }
+
+    //! never assigned to a definition.
+    static constexpr auto invalid_index = static_cast<typename index_type::value_type>(-1);
+private:
+    std::vector<value_type> values_;
+
+    boost::container::flat_map<id_type, index_type, std::less<>> indices_;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+} //namespace bkrl
+////////////////////////////////////////////////////////////////////////////////
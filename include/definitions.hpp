@@ -13,6 +13,7 @@
 #include "tile_sheet.hpp"
 #include "keyboard.hpp"
 #include "loot_table.hpp"
+#include "spawn_table.hpp"
 
 namespace bkrl {
 
@@ -27,7 +28,7 @@ class entity_definitions;
 //!
 //==============================================================================
 enum class filetype {
-    invalid, config, locale, item, message, texmap, entity, keymap, loot_table
+    invalid, config, locale, item, message, texmap, entity, keymap, loot_table, spawn_table
 };
 
 //==============================================================================
@@ -46,6 +47,8 @@ public:
 
     void load_loot_table(json::cref value);
 
+    void load_spawn_table(json::cref value);
+
     void load_locale(json::cref value);
 
     void load_config(json::cref value);
@@ -62,23 +65,25 @@ public:
 
     void get_file_names();
 
-    config                 const& get_config()      const { return config_; }
-    keymap                 const& get_keymap()      const { return keymap_; }
-    tile_map               const& get_tilemap()     const { return tilemap_; }
-    message_map            const& get_messages()    const { return messages_; }
-    item_definitions       const& get_items()       const { return item_defs_; }
-    entity_definitions     const& get_entities()    const { return entity_defs_; }
-    loot_table_definitions const& get_loot_tables() const { return loot_table_defs_; }
+    config                  const& get_config()       const { return config_; }
+    keymap                  const& get_keymap()       const { return keymap_; }
+    tile_map                const& get_tilemap()      const { return tilemap_; }
+    message_map             const& get_messages()     const { return messages_; }
+    item_definitions        const& get_items()        const { return item_defs_; }
+    entity_definitions      const& get_entities()     const { return entity_defs_; }
+    loot_table_definitions  const& get_loot_tables()  const { return loot_table_defs_; }
+    spawn_table_definitions const& get_spawn_tables() const { return spawn_table_defs_; }
 private:
     std::vector<path_string> files_;
 
-    config                 config_;
-    keymap                 keymap_;
-    tile_map               tilemap_;
-    message_map            messages_;
-    item_definitions       item_defs_;
-    entity_definitions     entity_defs_;
-    loot_table_definitions loot_table_defs_;
+    config                  config_;
+    keymap                  keymap_;
+    tile_map                tilemap_;
+    message_map             messages_;
+    item_definitions        item_defs_;
+    entity_definitions      entity_defs_;
+    loot_table_definitions  loot_table_defs_;
+    spawn_table_definitions spawn_table_defs_;
 };
 
 } //namespace bkrl
@@ -13,6 +13,7 @@
 #include "render_types.hpp"
 #include "random.hpp"
 #include "combat_types.hpp"
+#include "scheduler.hpp"
 
 #include "grid.hpp" //change to fwd def
 
@@ -20,6 +21,7 @@
 namespace bkrl {
 ////////////////////////////////////////////////////////////////////////////////
 class loot_table_definitions;
+class loot_batch;
 
 class entity;
 class entity_definitions;
@@ -53,6 +55,15 @@ public:
     void load_definitions(json::cref data);
     void load_locale(json::cref data);
 
+    //! Link the drops of every definition against @p loot_defs.
+    void link(loot_table_definitions const& loot_defs);
+
+    //! The dense index assigned to @p id when it was loaded.
+    entity_def_index index_of(entity_def_id id) const;
+
+    entity_locale     const& get_locale(entity_def_index index)     const;
+    entity_definition const& get_definition(entity_def_index index) const;
+
     entity_locale     const& get_locale(entity_def_id id)     const;
     entity_definition const& get_definition(entity_def_id id) const;
 
@@ -112,6 +123,13 @@ public:
     T maximum;
 };
 
+//==============================================================================
+//! How closely an entity is being simulated; see level::advance.
+//==============================================================================
+enum class sim_tier : uint8_t {
+    full, coarse, frozen
+};
+
 //==============================================================================
 //! The data common to all entities.
 //==============================================================================
@@ -119,6 +137,8 @@ struct entity_data_t {
     ranged_value<health_t> health;
     ipoint2                position;
     item_collection        items;
+    speed_t                speed = scheduler::speed_normal;
+    sim_tier               tier  = sim_tier::full;
 };
 
 //==============================================================================
@@ -215,9 +235,10 @@ public:
         return !(lhs == rhs);
     }
 public:
-    entity_id     instance_id;
-    entity_def_id id;
-    entity_data_t data;
+    entity_id        instance_id;
+    entity_def_id    id;
+    entity_def_index def_index {static_cast<uint16_t>(-1)}; //!< none for the player.
+    entity_data_t    data;
 };
 
 //==============================================================================
@@ -280,9 +301,16 @@ public:
             );
         }
         
+        //instances are kept sorted by instance id; see with_entity.
+        auto const in_order = instances_.empty()
+            || instances_.back().instance_id < ent.instance_id;
+
         instances_.push_back(std::move(ent));
 
-        if (!resize) {
+        if (!in_order) {
+            sort_instances_();
+            rebuild_map_();
+        } else if (!resize) {
             map_.insert(it, &instances_.back());
         } else {
             rebuild_map_();
@@ -360,7 +388,7 @@ public:
         function(ent);
 
         if (p != ent.position()) {
-            sort_map_();
+            reposition_(ent, p);
         }
 
         return true;
@@ -376,6 +404,46 @@ public:
         });
     }
 
+    //--------------------------------------------------------------------------
+    //! Find the entity with the instance id @p id and invoke @p function on it.
+    //--------------------------------------------------------------------------
+    template <typename Function>
+    bool with_entity(entity_id const id, Function&& function) {
+        auto const ptr = find_instance_(id);
+        if (!ptr) {
+            return false;
+        }
+
+        auto& ent = *const_cast<entity*>(ptr);
+        auto const p = ent.position();
+
+        function(ent);
+
+        //would cause mayhem
+        BK_ASSERT_DBG(id == ent.instance_id);
+
+        if (p != ent.position()) {
+            reposition_(ent, p);
+        }
+
+        return true;
+    }
+
+    //--------------------------------------------------------------------------
+    //! As above, but read only; safe to call concurrently.
+    //--------------------------------------------------------------------------
+    template <typename Function>
+    bool with_entity(entity_id const id, Function&& function) const {
+        auto const ptr = find_instance_(id);
+        if (!ptr) {
+            return false;
+        }
+
+        function(*ptr);
+
+        return true;
+    }
+
     //--------------------------------------------------------------------------
     //!
     //--------------------------------------------------------------------------
@@ -391,11 +459,18 @@ public:
             BK_ASSERT_DBG(id == ent.instance_id);
 
             if (p != ent.position()) {
-                sort_map_();
+                reposition_(ent, p);
             }
         }
     }
 
+    //--------------------------------------------------------------------------
+    //! The number of entities in the map.
+    //--------------------------------------------------------------------------
+    size_t size() const noexcept {
+        return instances_.size();
+    }
+
     //--------------------------------------------------------------------------
     //!
     //--------------------------------------------------------------------------
@@ -426,6 +501,57 @@ private:
         bkrl::sort(map_, less_pos_t {});
     }
 
+    //--------------------------------------------------------------------------
+    //! Move @p ent, which has just moved from @p from, to its new place in
+    //! map_; the rest of map_ is shifted along by one rather than sorted again.
+    //! Does nothing if that has already been done (i.e. by a nested call).
+    //--------------------------------------------------------------------------
+    void reposition_(entity& ent, point_t const from) {
+        auto const first = std::begin(map_);
+        auto const last  = std::end(map_);
+        auto const to    = ent.position();
+
+        //already in place?
+        auto const here = std::lower_bound(first, last, to, less_pos_t {});
+        if (here != last && *here == &ent
+         && (here == first    || less_pos_t::less((*(here - 1))->position(), to))
+         && (here + 1 == last || less_pos_t::less(to, (*(here + 1))->position()))
+        ) {
+            return;
+        }
+
+        //otherwise map_ is still sorted as if ent were at from
+        auto const it = std::lower_bound(first, last, from
+          , [&](entity const* const e, point_t const q) {
+                return less_pos_t::less((e == &ent) ? from : e->position(), q);
+            }
+        );
+
+        BK_ASSERT(it != last && *it == &ent);
+
+        if (less_pos_t::less(from, to)) {
+            auto const dst = std::lower_bound(it + 1, last, to, less_pos_t {});
+            std::rotate(it, it + 1, dst);
+        } else {
+            auto const dst = std::lower_bound(first, it, to, less_pos_t {});
+            std::rotate(dst, it, it + 1);
+        }
+    }
+
+    entity const* find_instance_(entity_id const id) const {
+        auto const result = bkrl::lower_bound(instances_, id
+          , [](entity const& lhs, entity_id const rhs) {
+                return lhs.instance_id < rhs;
+            }
+        );
+
+        if (!result.second || result.first->instance_id != id) {
+            return nullptr;
+        }
+
+        return &*result.first;
+    }
+
     template <typename Container, typename T, typename Predicate = std::less<>>
     static auto optional_find(Container&& c, T const& value, Predicate&& predicate = Predicate {}) {
         auto const result = bkrl::lower_bound(
@@ -441,26 +567,22 @@ private:
 };
 
 //==============================================================================
-//! @TODO
-//==============================================================================
-class spawn_table {
-public:
-    entity_def_id operator()(random_t&) const {
-        return entity_def_id {0};
-    }
-private:
-};
-
-//==============================================================================
+//! Generate an entity of the definition at @p index (see spawn_table); the
+//! items it carries are put in @p arena.
 //!
+//! @p drops is scratch space for rolling the entity's loot; reusing the same
+//! batch for every entity spawned means seeding a level allocates nothing
+//! for loot once it has grown large enough.
 //==============================================================================
 entity generate_entity(
-    random::generator&        gen
-  , entity_definitions const& entity_defs
-  , item_definitions   const& item_defs
+    random::generator&            gen
+  , entity_definitions     const& entity_defs
+  , item_definitions       const& item_defs
   , loot_table_definitions const& loot_defs
-  , item_store&               items
-  , spawn_table        const& table
+  , item_store&                   items
+  , entity_def_index       const  index
+  , loot_batch&                   drops
+  , item_arena                    arena = item_arena {}
 );
 
 //==============================================================================
@@ -482,10 +604,15 @@ public:
     equipment&       equip();
     equipment const& equip() const;
 
-    damage_t get_attack_value(random_t& gen, items_t items);
+    //! Reads the cached equipment_stats; nothing is looked up per attack.
+    damage_t get_attack_value(random_t& gen);
     
     defence_t get_defence_value(random_t& gen, defs_t defs, damage_type type);
 
+    //! The total weight of the inventory and equipment; read from totals kept
+    //! as items come and go.
+    weight_total_t carried_weight() const noexcept;
+
     bool can_pass_tile(ipoint2 const p, grid_storage const& grid) const {
         if (grid.get(attribute::tile_type, p) == tile_type::invalid) {
             return true;
@@ -18,6 +18,7 @@ class message_map;
 
 class item_definitions;
 class item_collection;
+class item_id_view;
 class item_store;
 
 namespace gui {
@@ -112,7 +113,14 @@ public:
     item_id at(int index);
     
     void insert(item_id id);
-    virtual void insert(item_collection const& items);
+    virtual void insert(item_id_view items);
+
+    //--------------------------------------------------------------------------
+    //! As insert, but with identical items sharing a single row. at() gives
+    //! just one item of a row, so this is only for lists nothing is chosen
+    //! from, like the inventory.
+    //--------------------------------------------------------------------------
+    void insert_grouped(item_id_view items);
 
     int  size()  const noexcept;
     bool empty() const noexcept;
@@ -130,7 +138,7 @@ public:
 
     using item_list::item_list;
    
-    void insert(item_collection const& items) override;
+    void insert(item_id_view items) override;
 };
 
 //==============================================================================
@@ -45,22 +45,36 @@ private:
 
 namespace detail {
     struct tag_item_def;
+    struct tag_item_def_index;
     struct tag_item_instance;
+    struct tag_item_arena;
     struct tag_entity_def;
+    struct tag_entity_def_index;
     struct tag_entity_instance;
     struct tag_loot_table_def;
+    struct tag_loot_table_def_index;
     struct tag_spawn_table_def;
+    struct tag_spawn_table_def_index;
     struct tag_language;
 } //namespace detail
 
 using item_def_id        = tagged_id<detail::tag_item_def>;
-using item_id            = tagged_id<detail::tag_item_instance>;
+using item_id            = tagged_id<detail::tag_item_instance, uint64_t>;
 using entity_def_id      = tagged_id<detail::tag_entity_def>;
 using entity_id          = tagged_id<detail::tag_entity_instance>;
 using loot_table_def_id  = tagged_id<detail::tag_loot_table_def>;
 using spawn_table_def_id = tagged_id<detail::tag_spawn_table_def>;
 using lang_id            = tagged_id<detail::tag_language>;
 
+//! dense, load order indices of definitions; see definition_table.
+using item_def_index        = tagged_id<detail::tag_item_def_index,        uint16_t>;
+using entity_def_index      = tagged_id<detail::tag_entity_def_index,      uint16_t>;
+using loot_table_def_index  = tagged_id<detail::tag_loot_table_def_index,  uint16_t>;
+using spawn_table_def_index = tagged_id<detail::tag_spawn_table_def_index, uint16_t>;
+
+//! a partition of the item_store; see item_store::create_arena.
+using item_arena = tagged_id<detail::tag_item_arena, uint16_t>;
+
 ////////////////////////////////////////////////////////////////////////////////
 } //namespace bkrl
 ////////////////////////////////////////////////////////////////////////////////
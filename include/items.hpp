@@ -9,6 +9,11 @@
 #include <memory>
 #include <vector>
 #include <bitset>
+#include <iterator>
+#include <array>
+#include <numeric>
+
+#include <boost/container/small_vector.hpp>
 
 #include "identifier.hpp"
 #include "optional.hpp"
@@ -20,6 +25,7 @@
 #include "combat_types.hpp"
 
 #include "algorithm.hpp"
+#include "scope_exit.hpp"
 
 ////////////////////////////////////////////////////////////////////////////////
 namespace bkrl {
@@ -40,19 +46,95 @@ namespace detail { class item_store_impl; }
 namespace detail { class item_definitions_impl; }
 namespace detail { class equipment_impl; }
 
-using weight_t = int16_t;
+using weight_t       = int16_t; //!< the weight of a single item.
+using weight_total_t = int32_t; //!< the weight of, or number of, many items.
 ////////////////////////////////////////////////////////////////////////////////
 
+//==============================================================================
+//! General item type.
+//==============================================================================
+enum class item_type : uint8_t {
+    invalid
+  
+  , none = 0
+  , weapon
+  , armor
+  , scroll
+  , potion
+  , container
+
+  , enum_size
+};
+
+//==============================================================================
+//! Running totals for a set of items, kept up to date as items are added and
+//! removed so that reading them never means visiting the items.
+//!
+//! Totals are wider than a single item's weight_t; a few hundred heavy items
+//! would overflow it.
+//==============================================================================
+struct item_totals {
+    using counts_t = std::array<weight_total_t, static_cast<size_t>(item_type::enum_size)>;
+
+    weight_total_t weight = weight_total_t {0}; //!< total weight of the items.
+    counts_t       counts = counts_t {};        //!< the number of items of each item_type.
+
+    int count(item_type const type) const noexcept {
+        return counts[static_cast<size_t>(type)];
+    }
+
+    //! The number of items counted, of any type.
+    int count() const noexcept {
+        return std::accumulate(std::begin(counts), std::end(counts), 0);
+    }
+
+    void add(item_type const type, weight_t const w) noexcept {
+        weight += w;
+        ++counts[static_cast<size_t>(type)];
+    }
+
+    void subtract(item_type const type, weight_t const w) noexcept {
+        BK_ASSERT_DBG(count(type) > 0);
+
+        weight -= w;
+        --counts[static_cast<size_t>(type)];
+    }
+};
+
+
 //==============================================================================
 //! item_collection
+//!
+//! Most entities and item stacks hold only a handful of items, so the first
+//! few are stored inline and the heap is only touched beyond that.
+//!
+//! Items are kept sorted by id so that finding or removing one is a binary
+//! search, and so that adding many at once is a single merge.
+//!
+//! Collections that are added to and removed from with the overloads taking
+//! the item_store (i.e. inventories) also keep item_totals up to date; those
+//! used as plain lists of ids just leave them empty. A collection becomes
+//! tracked with its first tracked insert and stays so until clear(); mixing
+//! the two kinds of operation would leave the totals wrong, so it is checked
+//! even in optimized builds.
 //==============================================================================
 class item_collection {
 public:
+    using store_t = item_store const&;
+    using defs_t  = item_definitions const&;
+
+    static constexpr size_t inline_capacity = 4;
+
     bool empty() const noexcept { return items_.empty(); }
     int  size()  const noexcept { return static_cast<int>(items_.size()); }
 
+    //! The totals for the items; only kept for tracked collections.
+    item_totals const& totals() const noexcept { return totals_; }
+
     void clear() {
         items_.clear();
+        totals_  = item_totals {};
+        tracked_ = false;
     }
 
     void reserve(size_t const n) {
@@ -60,38 +142,54 @@ public:
     }
 
     void insert(item_id const itm) {
-        items_.push_back(itm);
+        BK_ASSERT_OPT(!tracked_);
+        insert_(itm);
     }
 
-    bool remove(item_id const itm) {
-        auto result = false;
-        
-        bkrl::find_and(items_, itm, [&](auto& it) {
-            result = true;
-            items_.erase(it);    
-        });
+    //! As insert, but counting @p itm towards totals().
+    void insert(item_id itm, store_t store, defs_t defs);
 
-        return result;
+    //--------------------------------------------------------------------------
+    //! Insert every item in @p items; they are appended, sorted and merged in
+    //! one pass rather than inserted one at a time.
+    //--------------------------------------------------------------------------
+    template <typename Range>
+    void insert_all(Range const& items) {
+        BK_ASSERT_OPT(!tracked_);
+        insert_all_(items);
     }
 
-    template <typename Function>
-    void remove_nth_and(int const n, Function&& function) {
-        BK_ASSERT_DBG(n >= 0 && n < items_.size());
+    //! As insert_all, but counting each of @p items towards totals().
+    template <typename Range>
+    void insert_all(Range const& items, store_t store, defs_t defs) {
+        begin_tracked_();
+
+        for (auto const itm : items) {
+            add_(itm, store, defs);
+        }
 
-        auto const it = items_.begin() + n;
+        insert_all_(items);
+    }
 
-        function(*it);
+    bool contains(item_id const itm) const noexcept {
+        return std::binary_search(std::begin(items_), std::end(items_), itm);
+    }
 
-        items_.erase(it);
+    bool remove(item_id const itm) {
+        BK_ASSERT_OPT(!tracked_);
+        return remove_(itm);
     }
 
+    //! As remove, but taking @p itm out of totals().
+    bool remove(item_id itm, store_t store, defs_t defs);
+
     template <typename Function>
     void remove_all_and(Function&& function) {
         for (auto& i : items_) {
             function(i);
         }
 
-        items_.clear();
+        clear();
     }
 
     template <typename Function>
@@ -100,24 +198,157 @@ public:
             function(i);
         }
     }
+
+    item_id const* data() const noexcept {
+        return items_.data();
+    }
+
+    auto begin() const noexcept { return items_.begin(); }
+    auto end()   const noexcept { return items_.end(); }
+
+    //! Whether the items are held inline, i.e. without a heap allocation.
+    bool is_inline() const noexcept {
+        auto const first = reinterpret_cast<char const*>(this);
+        auto const last  = first + sizeof(*this);
+        auto const p     = reinterpret_cast<char const*>(items_.data());
+
+        return p >= first && p < last;
+    }
 private:
-    std::vector<item_id> items_;
+    //! Called by every tracked operation; an untracked collection can only
+    //! become tracked while it is empty.
+    void begin_tracked_() {
+        BK_ASSERT_OPT(tracked_ || empty());
+        tracked_ = true;
+    }
+
+    void add_(item_id itm, store_t store, defs_t defs);
+    void subtract_(item_id itm, store_t store, defs_t defs);
+
+    void insert_(item_id const itm) {
+        auto const it = std::lower_bound(std::begin(items_), std::end(items_), itm);
+        BK_ASSERT_DBG(it == std::end(items_) || *it != itm);
+
+        items_.insert(it, itm);
+    }
+
+    template <typename Range>
+    void insert_all_(Range const& items) {
+        auto const n = items_.size();
+
+        items_.insert(std::end(items_), std::begin(items), std::end(items));
+
+        auto const beg = std::begin(items_);
+        auto const mid = beg + static_cast<ptrdiff_t>(n);
+        auto const end = std::end(items_);
+
+        std::sort(mid, end);
+        std::inplace_merge(beg, mid, end);
+    }
+
+    bool remove_(item_id const itm) {
+        auto const end = std::end(items_);
+        auto const it  = std::lower_bound(std::begin(items_), end, itm);
+
+        if (it == end || *it != itm) {
+            return false;
+        }
+
+        items_.erase(it);
+        return true;
+    }
+
+    boost::container::small_vector<item_id, inline_capacity> items_;
+    item_totals totals_;
+    bool        tracked_ = false; //!< whether this is a tracked collection.
 };
 
 //==============================================================================
-//! General item type.
+//! A non-owning, read only view of item ids laid out @p stride bytes apart;
+//! e.g. a single field of an array of records.
+//!
+//! Only valid for as long as the storage it refers to is left unmodified.
 //==============================================================================
-enum class item_type : uint8_t {
-    invalid
-  
-  , none = 0
-  , weapon
-  , armor
-  , scroll
-  , potion
-  , container
+class item_id_view {
+public:
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = item_id;
+        using difference_type   = ptrdiff_t;
+        using pointer           = item_id const*;
+        using reference         = item_id const&;
+
+        iterator() = default;
+
+        iterator(char const* const p, size_t const stride) noexcept
+          : p_ {p}, stride_ {stride}
+        {
+        }
 
-  , enum_size
+        reference operator*() const noexcept {
+            return *reinterpret_cast<pointer>(p_);
+        }
+
+        iterator& operator++() noexcept {
+            p_ += stride_;
+            return *this;
+        }
+
+        iterator operator++(int) noexcept {
+            auto const result = *this;
+            ++(*this);
+            return result;
+        }
+
+        friend bool operator==(iterator const lhs, iterator const rhs) noexcept {
+            return lhs.p_ == rhs.p_;
+        }
+
+        friend bool operator!=(iterator const lhs, iterator const rhs) noexcept {
+            return !(lhs == rhs);
+        }
+    private:
+        char const* p_      = nullptr;
+        size_t      stride_ = sizeof(item_id);
+    };
+
+    item_id_view() = default;
+
+    item_id_view(item_id const* const first, size_t const size, size_t const stride = sizeof(item_id)) noexcept
+      : first_  {reinterpret_cast<char const*>(first)}
+      , size_   {size}
+      , stride_ {stride}
+    {
+    }
+
+    //! every item in @p items.
+    item_id_view(item_collection const& items) noexcept
+      : item_id_view {items.data(), static_cast<size_t>(items.size())}
+    {
+    }
+
+    bool   empty() const noexcept { return size_ == 0; }
+    int    size()  const noexcept { return static_cast<int>(size_); }
+
+    item_id operator[](size_t const i) const noexcept {
+        BK_ASSERT_DBG(i < size_);
+        return *reinterpret_cast<item_id const*>(first_ + i * stride_);
+    }
+
+    iterator begin() const noexcept { return {first_, stride_}; }
+    iterator end()   const noexcept { return {first_ + size_ * stride_, stride_}; }
+
+    template <typename Function>
+    void for_each_item(Function&& function) const {
+        for (auto const i : *this) {
+            function(i);
+        }
+    }
+private:
+    char const* first_  = nullptr;
+    size_t      size_   = 0;
+    size_t      stride_ = sizeof(item_id);
 };
 
 extern template item_type from_hash(hash_t hash);
@@ -209,6 +440,10 @@ struct potion_data {
 //==============================================================================
 //! An unrestriced union of item specific data types. Care must be take to
 //! properly construct / destruct it.
+//!
+//! Every item pays for the largest member, so only small, fixed size data
+//! belongs here; anything bigger or rarely needed goes in a side table kept
+//! by item_store (see item_store::origin).
 //==============================================================================
 #if BOOST_COMP_MSVC
 #   pragma warning( disable : 4582 4583 )
@@ -216,16 +451,19 @@ struct potion_data {
 union item_data_t {
     friend item;
 public:
-    item_collection stack;
     weapon_data weapon;
     armor_data  armor;
     potion_data potion;
-    size_t      dummy;
+    uint8_t     dummy;
 
     ~item_data_t() { }
 private:
-    item_data_t() noexcept { new (&dummy) size_t {}; }
+    //! Initialise the largest member so that every byte starts out zeroed.
+    item_data_t() noexcept : armor {} { }
 };
+
+static_assert(sizeof(armor_data) >= sizeof(weapon_data)
+           && sizeof(armor_data) >= sizeof(potion_data), "see item_data_t()");
 #if BOOST_COMP_MSVC
 #   pragma warning( default : 4582 4583 )
 #endif
@@ -240,6 +478,9 @@ struct item_render_info_t {
 
 //==============================================================================
 //! Instance specific realization of an item definition.
+//!
+//! Kept as small as possible: the index of the definition, the type and the
+//! type specific data. Where the item came from is kept by the item_store.
 //==============================================================================
 class item {
 public:
@@ -249,7 +490,7 @@ public:
     item()                       = default;
     item(item const&)            = delete;
     item& operator=(item const&) = delete;
-    item& operator=(item&&)      = delete;
+    item& operator=(item&&);
 
     item(item&&);
     ~item();
@@ -275,6 +516,12 @@ public:
     //--------------------------------------------------------------------------
     item_render_info_t render_info(defs_t defs) const;
 
+    //--------------------------------------------------------------------------
+    //! Whether @p other is interchangeable with this item; i.e. has the same
+    //! definition and the same instance data.
+    //--------------------------------------------------------------------------
+    bool can_stack_with(item const& other) const noexcept;
+
     //--------------------------------------------------------------------------
     template <typename Visitor>
     void with_data(Visitor&& visitor) const {
@@ -298,10 +545,9 @@ public:
     //
     ////////////////////////////////////////////////////////////////////////////
 
-    item_def_id     id;
-    item_birthplace origin;
-    item_data_t     data;
-    item_type       type;
+    item_def_index def_index;
+    item_data_t    data;
+    item_type      type;
 };
 
 //==============================================================================
@@ -339,22 +585,22 @@ public:
     ////////////////////////////////////////////////////////////////////////////
 
     //--------------------------------------------------------------------------
-    //! insert @p itm at @p p.
+    //! insert @p itm at @p p; it goes on top of any items already there.
     //--------------------------------------------------------------------------
     void insert_at(point_t const p, item_id const itm) {
-        insert_(p, itm);
-        bkrl::sort(items_);
+        auto const it = std::upper_bound(std::begin(items_), std::end(items_), p);
+        items_.insert(it, record_t {{itm, p}});
     }
 
     //--------------------------------------------------------------------------
     //! removes all the items from @p items and inserts them at @p p.
     //--------------------------------------------------------------------------
     void insert_at(point_t const p, item_collection& items) {
-        items.remove_all_and([&](item_id const itm) {
-            insert_(p, itm);
+        insert_batch([&](auto&& insert) {
+            items.remove_all_and([&](item_id const itm) {
+                insert(p, itm);
+            });
         });
-        
-        bkrl::sort(items_);
     }
 
     //--------------------------------------------------------------------------
@@ -362,11 +608,30 @@ public:
     //--------------------------------------------------------------------------
     template <typename Iterator>
     void insert_at(point_t const p, Iterator const beg, Iterator const end) {
-        std::for_each(beg, end, [&](item_id const itm) {
+        insert_batch([&](auto&& insert) {
+            std::for_each(beg, end, [&](item_id const itm) {
+                insert(p, itm);
+            });
+        });
+    }
+
+    //--------------------------------------------------------------------------
+    //! Insert any number of items, anywhere, putting the map back in order
+    //! only once at the end.
+    //!
+    //! @p function is invoked as function(insert) where insert(p, itm) inserts
+    //! itm at p. Items at the same position keep the order they were inserted
+    //! in, as with repeated calls to insert_at.
+    //--------------------------------------------------------------------------
+    template <typename Function>
+    void insert_batch(Function&& function) {
+        auto const first = items_.size();
+
+        on_scope_exit(merge_(first));
+
+        function([&](point_t const p, item_id const itm) {
             insert_(p, itm);
         });
-        
-        bkrl::sort(items_);
     }
 
     ////////////////////////////////////////////////////////////////////////////
@@ -383,6 +648,21 @@ public:
         });
     }
 
+    //--------------------------------------------------------------------------
+    //! The items at @p p, straight out of the map; invalidated by any change
+    //! to the map.
+    //--------------------------------------------------------------------------
+    item_id_view items_at(point_t const p) const noexcept {
+        auto const range = bkrl::equal_range(items_, p);
+        auto const n     = std::distance(range.first, range.second);
+
+        if (n == 0) {
+            return {};
+        }
+
+        return {&range.first->value.first, static_cast<size_t>(n), sizeof(record_t)};
+    }
+
     //--------------------------------------------------------------------------
     //! for every item calls function(item_id, point_t).
     //--------------------------------------------------------------------------
@@ -426,7 +706,7 @@ public:
             return r.id() == itm;
         });
 
-        if (it == end) {
+        if (it == range.second) {
             return false;
         }
 
@@ -455,6 +735,38 @@ public:
         return n;
     }
 
+    //--------------------------------------------------------------------------
+    //! Move all the items at @p p into @p items in one pass.
+    //! @returns the number of items moved.
+    //--------------------------------------------------------------------------
+    int remove_items_at(point_t const p, item_collection& items) {
+        auto const range = bkrl::equal_range(items_, p);
+        auto const n     = std::distance(range.first, range.second);
+
+        items.insert_all(items_at(p));
+        items_.erase(range.first, range.second);
+
+        return static_cast<int>(n);
+    }
+
+    //--------------------------------------------------------------------------
+    //! As above, but counting the items towards the totals for @p items.
+    //--------------------------------------------------------------------------
+    int remove_items_at(
+        point_t          const  p
+      , item_collection&        items
+      , item_store       const& store
+      , item_definitions const& defs
+    ) {
+        auto const range = bkrl::equal_range(items_, p);
+        auto const n     = std::distance(range.first, range.second);
+
+        items.insert_all(items_at(p), store, defs);
+        items_.erase(range.first, range.second);
+
+        return static_cast<int>(n);
+    }
+
     template <typename Function>
     bool with_nth_at(point_t const p, int const n, Function&& function) const {
         return with_nth_at_(p, n, [&](auto const& it) {
@@ -498,31 +810,235 @@ private:
         });
     }
 
+    //! merge the unsorted run of items appended from @p first onwards.
+    void merge_(size_t const first) {
+        auto const beg = std::begin(items_);
+        auto const mid = beg + static_cast<ptrdiff_t>(first);
+        auto const end = std::end(items_);
+
+        std::stable_sort(mid, end);
+        std::inplace_merge(beg, mid, end);
+    }
+
     std::vector<record_t> items_;
 };
 
+//==============================================================================
+//! A per tile summary of an item_map: how many items are on each tile, and
+//! what to draw for each tile with any items on it.
+//!
+//! Counts are kept in a dense grid so looking one up is O(1); the stacks are
+//! kept apart, in the same order as the item_map, so drawing only visits
+//! tiles that actually have items. Call update whenever the items at a
+//! position change.
+//==============================================================================
+class item_stack_summary {
+public:
+    using point_t = ipoint2;
+
+    struct stack_t {
+        point_t            pos;
+        int                count;
+        item_render_info_t info; //!< the item itself, or a pile if count > 1.
+    };
+
+    item_stack_summary(int width, int height);
+
+    //--------------------------------------------------------------------------
+    //! Bring the summary for @p p up to date with @p map.
+    //--------------------------------------------------------------------------
+    void update(
+        point_t                 p
+      , item_map         const& map
+      , item_store       const& store
+      , item_definitions const& defs
+    );
+
+    //! The number of items at @p p.
+    int count_at(point_t const p) const noexcept {
+        return counts_[index_(p)];
+    }
+
+    //--------------------------------------------------------------------------
+    //! for each tile with items on it calls function(stack_t const&).
+    //--------------------------------------------------------------------------
+    template <typename Function>
+    void for_each_stack(Function&& function) const {
+        for (auto const& s : stacks_) {
+            function(s);
+        }
+    }
+private:
+    size_t index_(point_t const p) const noexcept {
+        BK_ASSERT_DBG(p.x >= 0 && p.x < width_ && p.y >= 0 && p.y < height_);
+        return static_cast<size_t>(p.y) * width_ + p.x;
+    }
+
+    int width_;
+    int height_;
+
+    std::vector<uint16_t> counts_;
+    std::vector<stack_t>  stacks_;
+};
+
 //==============================================================================
 //! A container of all items.
+//!
+//! Ids stay valid until the item is removed; after that the id is never
+//! handed out again for as long as it could be confused with the old one.
+//!
+//! Items are partitioned into arenas. The global arena, item_arena {}, holds
+//! the items that belong to no level (i.e. the player's); each level creates
+//! an arena of its own for its floor loot and monster inventories. The items
+//! in an arena are stored contiguously and are destroyed all at once when the
+//! arena is released. Moving an item to another arena gives it a new id.
+//!
+//! Ids are 64 bits, which leaves room for far more arenas, and far more items
+//! in each, than a game will ever use; running out of either is fatal.
 //==============================================================================
 class item_store {
 public:
     using rvalue          = item&&;
     using reference       = item&;
     using const_reference = item const&;
+
+    //! The most arenas that can be in use at once, the global arena included.
+    static constexpr int max_arenas = 1 << 15;
+
+    //! The most items an arena can hold at once. Slots are retired after being
+    //! reused about a million times, so a long lived arena can hold a few less.
+    static constexpr size_t max_arena_items = size_t {1} << 28;
     
     item_store();
     item_store(item_store&&);
     ~item_store();
 
-    item_id insert(rvalue value);
-    void    remove(item_id id);
+    //! A new, empty, arena.
+    item_arena create_arena();
+
+    //! Destroy every item in @p arena at once and make it available for reuse;
+    //! any ids for those items are left invalid.
+    void release_arena(item_arena arena);
+
+    item_id insert(
+        rvalue                 value
+      , item_birthplace const& origin = item_birthplace {}
+      , item_arena      const  arena  = item_arena {}
+    );
+
+    void remove(item_id id);
+
+    //--------------------------------------------------------------------------
+    //! Move the item @p id into @p arena.
+    //! @returns the item's new id; @p id itself if it is already in @p arena.
+    //--------------------------------------------------------------------------
+    item_id move_to(item_id id, item_arena arena);
+
+    //! The arena the item @p id belongs to.
+    item_arena arena_of(item_id id) const;
+
+    //! Where the item @p id was generated.
+    item_birthplace const& origin(item_id id) const;
+
+    //--------------------------------------------------------------------------
+    //! The items inside the container @p id. Few items are containers, so
+    //! contents are kept in a side table rather than in every item; they
+    //! follow the container when it moves to another arena and are dropped
+    //! when it is removed. The items themselves stay where they are.
+    //! @pre store[id].type == item_type::container
+    //--------------------------------------------------------------------------
+    item_collection&       contents(item_id id);
+    item_collection const& contents(item_id id) const;
+
+    //! Whether @p id refers to an item that is still in the store.
+    bool contains(item_id id) const noexcept;
+
+    //! The number of items in the store, in every arena.
+    size_t size() const noexcept;
+
+    //! The number of items in @p arena.
+    size_t size(item_arena arena) const noexcept;
+
+    //! One more than the largest arena ever created; released arenas are
+    //! empty.
+    int arena_count() const noexcept;
 
     reference       operator[](item_id id);
     const_reference operator[](item_id id) const;
+
+    //! All size(@p arena) items in @p arena, contiguously and in no particular
+    //! order; invalidated by insert and remove.
+    item const* data(item_arena arena) const noexcept;
+
+    //--------------------------------------------------------------------------
+    //! for every item in @p arena calls function(item const&), in no
+    //! particular order.
+    //--------------------------------------------------------------------------
+    template <typename Function>
+    void for_each_item(item_arena const arena, Function&& function) const {
+        auto const first = data(arena);
+        auto const last  = first + size(arena);
+
+        for (auto it = first; it != last; ++it) {
+            function(*it);
+        }
+    }
+
+    //--------------------------------------------------------------------------
+    //! for every item calls function(item const&), an arena at a time.
+    //--------------------------------------------------------------------------
+    template <typename Function>
+    void for_each_item(Function&& function) const {
+        auto const n = arena_count();
+        for (int i = 0; i < n; ++i) {
+            for_each_item(item_arena {static_cast<uint16_t>(i)}, function);
+        }
+    }
 private:
     std::unique_ptr<detail::item_store_impl> impl_;
 };
 
+//==============================================================================
+//! Owns an arena of an item_store; the arena, along with every item still in
+//! it, is released when this is destroyed.
+//==============================================================================
+class unique_item_arena {
+public:
+    explicit unique_item_arena(item_store& store);
+
+    unique_item_arena(unique_item_arena&& other) noexcept;
+    unique_item_arena& operator=(unique_item_arena&& rhs) noexcept;
+
+    ~unique_item_arena();
+
+    //! Release the arena now.
+    void reset();
+
+    item_arena get() const noexcept { return arena_; }
+private:
+    item_store* store_;
+    item_arena  arena_;
+};
+
+//==============================================================================
+//! A run of interchangeable items; see group_items.
+//==============================================================================
+struct item_group {
+    item_id id;    //!< the first item in the group.
+    int     count; //!< the number of items in the group.
+};
+
+//==============================================================================
+//! Collapse @p items into groups of items that can stack with one another
+//! (see item::can_stack_with), ordered by definition. @p out is cleared
+//! first.
+//==============================================================================
+void group_items(
+    item_id_view             items
+  , item_store const&        store
+  , std::vector<item_group>& out
+);
+
 //==============================================================================
 //! Locale (language) specific item data.
 //==============================================================================
@@ -547,6 +1063,15 @@ public:
     void load_definitions(json::cref data);
     void load_locale(json::cref data);
 
+    //--------------------------------------------------------------------------
+    //! The dense index assigned to @p id when it was loaded; resolving an
+    //! index is a plain array lookup whereas resolving an id is a search.
+    //--------------------------------------------------------------------------
+    item_def_index index_of(item_def_id id) const;
+
+    item_locale     const& get_locale(item_def_index index)     const;
+    item_definition const& get_definition(item_def_index index) const;
+
     item_locale     const& get_locale(item_def_id id)     const;
     item_definition const& get_definition(item_def_id id) const;
 
@@ -560,6 +1085,28 @@ private:
     std::unique_ptr<detail::item_definitions_impl> impl_;
 };
 
+//==============================================================================
+//! Combat related totals for everything currently equipped.
+//!
+//! Maintained by equipment as items are equipped and unequipped so that
+//! resolving an attack only has to read a few fields.
+//==============================================================================
+struct equipment_stats {
+    using armor_t = std::array<int16_t, static_cast<size_t>(damage_type::enum_size)>;
+
+    //! damage dealt by the wielded weapon; uniform over [dmg_min, dmg_max].
+    int16_t     dmg_min  = int16_t {1};
+    int16_t     dmg_max  = int16_t {1};
+    damage_type dmg_type = damage_type::blunt;
+
+    armor_t     armor  = armor_t {};     //!< total armor against each damage_type.
+    item_totals totals = item_totals {}; //!< totals for the equipped items.
+
+    int16_t armor_against(damage_type const type) const noexcept {
+        return armor[static_cast<size_t>(type)];
+    }
+};
+
 //==============================================================================
 //!
 //==============================================================================
@@ -585,6 +1132,9 @@ public:
     optional<item_id> match_any(equip_slot_flags flags) const;
 
     item_collection list() const;
+
+    //! The totals for the currently equipped items.
+    equipment_stats const& stats() const noexcept;
 private:
     std::unique_ptr<detail::equipment_impl> impl_;
 };
@@ -598,6 +1148,7 @@ item_id generate_item(
   , item_store&             store
   , item_definitions const& defs
   , item_birthplace         origin
+  , item_arena              arena = item_arena {}
 );
 
 #ifdef BK_TEST
@@ -277,6 +277,10 @@ extern field_string const field_slot;
 extern field_string const field_player;
 extern field_string const field_armor_level;
 extern field_string const field_weight;
+extern field_string const field_speed;
+extern field_string const field_sim_radius;
+extern field_string const field_sim_interval;
+extern field_string const field_spawns;
 //------------------------------------------------------------------------------
 extern field_string const filetype_config;
 extern field_string const filetype_locale;
@@ -286,6 +290,7 @@ extern field_string const filetype_tilemap;
 extern field_string const filetype_keymap;
 extern field_string const filetype_messages;
 extern field_string const filetype_loot;
+extern field_string const filetype_spawn;
 //------------------------------------------------------------------------------
 template <typename T> path_string         get_path_string(T)          = delete;
 template <typename T> path_string         get_filename(T)             = delete;
@@ -5,13 +5,18 @@
 //##############################################################################
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <memory>
 #include <vector>
 #include <functional>
 
 #include "assert.hpp"
+#include "hash.hpp"
 #include "identifier.hpp"
+#include "optional.hpp"
 #include "random_forward.hpp"
+#include "random.hpp"
 #include "json_forward.hpp"
 #include "string.hpp"
 
@@ -36,8 +41,17 @@ inline void assign(string_ref const src, fixed_string<N>& dst) {
     dst[dst_size] = 0;
 }
 
+template <typename SrcCont, typename DstCont>
+inline void append_to(SrcCont const& src, DstCont& dst) {
+    using std::begin;
+    using std::end;
+
+    dst.insert(end(dst), begin(src), end(src));
+}
+
 class loot_table_definitions;
 class loot_table;
+class loot_batch;
 
 namespace detail { class loot_table_definitions_impl; }
 namespace detail { class loot_table_parser_impl; }
@@ -53,11 +67,28 @@ struct loot_rule_data_t {
 
     using string_t = fixed_string<31>;
 
-    hash_t   id;              //!< id of the resulting item or table.
-    uint16_t count_lo;        //!< the lower bound on the quantity generated.
-    uint16_t count_hi;        //!< the upper bound on the quantity generated.
-    string_t id_debug_string; //!< snipped of the string used to generate the id hash.
-    id_t     id_type;         //!< indicated either an item or table result.
+    hash_t               id;              //!< id of the resulting item or table.
+    loot_table_def_index table;           //!< index of the table for table_ref; set by link.
+    uint16_t             count_lo;        //!< the lower bound on the quantity generated.
+    uint16_t             count_hi;        //!< the upper bound on the quantity generated.
+    string_t             id_debug_string; //!< snipped of the string used to generate the id hash.
+    id_t                 id_type;         //!< indicated either an item or table result.
+};
+
+//==============================================================================
+//! a single result of generating a loot table.
+//==============================================================================
+struct loot_result_t {
+    item_def_id id;    //!< the item generated.
+    uint16_t    count; //!< the quantity generated.
+};
+
+//==============================================================================
+//! the expected quantity of an item generated by a single roll of a table.
+//==============================================================================
+struct loot_expectation_t {
+    item_def_id id;
+    double      count;
 };
 
 //==============================================================================
@@ -75,7 +106,36 @@ public:
     void load_definitions(json::cref data);
 
     //--------------------------------------------------------------------------
-    loot_table const& operator[](loot_table_def_id id) const;
+    //! Resolve every reference from one table to another to an index, and
+    //! flatten nesting that makes no difference (see loot_table::link). Done
+    //! once all the tables are loaded; tables can't be generated before.
+    //--------------------------------------------------------------------------
+    void link();
+
+    //--------------------------------------------------------------------------
+    //! A table that refers back to itself, directly or not, if there is one.
+    //--------------------------------------------------------------------------
+    optional<loot_table_def_id> find_cycle() const;
+
+    //--------------------------------------------------------------------------
+    //! The dense index assigned to @p id when it was loaded.
+    //--------------------------------------------------------------------------
+    loot_table_def_index index_of(loot_table_def_id id) const;
+
+    //--------------------------------------------------------------------------
+    //! The exact expected counts of the table at @p index, as
+    //! loot_table::expected_counts; computed once for every table by link, so
+    //! a table shared by many others is only walked once.
+    //! @pre link() has been called.
+    //--------------------------------------------------------------------------
+    std::vector<loot_expectation_t> const& expected_counts(loot_table_def_index index) const;
+
+    //--------------------------------------------------------------------------
+    loot_table const& operator[](loot_table_def_index index) const;
+    loot_table const& operator[](loot_table_def_id    id)    const;
+
+    //! The number of tables; indices are [0, size()).
+    int size() const noexcept;
 private:
     std::unique_ptr<detail::loot_table_definitions_impl> impl_;
 };
@@ -93,6 +153,7 @@ public:
     using defs_t = loot_table_definitions const&;
     using rule_t = loot_rule_data_t const&;
 
+    //! the type erased form of the sinks accepted by generate.
     using write_t = std::function<void (item_def_id, uint16_t)>;
 
     //--------------------------------------------------------------------------
@@ -134,7 +195,77 @@ public:
     }
 
     //--------------------------------------------------------------------------
-    void generate(random_t& gen, defs_t defs, write_t const& write) const;
+    //! Roll the table once, invoking @p sink as void (item_def_id, uint16_t)
+    //! for each item generated. The sink is called directly, not through a
+    //! write_t, so a lambda is inlined and nothing is allocated.
+    //--------------------------------------------------------------------------
+    template <typename Sink>
+    void generate(random_t& gen, defs_t defs, Sink&& sink) const {
+        if (type_ == roll_t::roll_all) {
+            roll_all_(gen, defs, sink);
+        } else if (type_ == roll_t::choose_one) {
+            choose_one_(gen, defs, sink);
+        } else {
+            BK_TODO_FAIL();
+        }
+    }
+
+    //--------------------------------------------------------------------------
+    //! Roll the table @p n times, appending each roll's results to @p out.
+    //! Reusing (clearing) the same batch doesn't allocate once it has grown
+    //! large enough.
+    //--------------------------------------------------------------------------
+    void generate_n(random_t& gen, defs_t defs, size_t n, loot_batch& out) const;
+
+    //--------------------------------------------------------------------------
+    //! The exact expected quantity of each item generated by one roll of the
+    //! table, ordered by id; computed from the weights and chances of the
+    //! rules rather than by sampling. Nested tables contribute their counts
+    //! as cached by @p defs, scaled by how many times they are generated.
+    //! @pre the table is linked, and @p defs too.
+    //--------------------------------------------------------------------------
+    std::vector<loot_expectation_t> expected_counts(defs_t defs) const;
+
+    //--------------------------------------------------------------------------
+    //! Resolve each table_ref rule to the index of its table in @p defs.
+    //!
+    //! A rule that generates a table once, where that table always yields
+    //! exactly its one rule, is replaced by that rule; the result is the same
+    //! without the extra roll and level of nesting.
+    //!
+    //! @pre the tables in @p defs don't refer back to themselves.
+    //--------------------------------------------------------------------------
+    void link(defs_t defs);
+
+    bool is_linked() const noexcept { return linked_; }
+
+    //--------------------------------------------------------------------------
+    //! The rule that generating this table always rolls exactly once, if
+    //! there is one.
+    //--------------------------------------------------------------------------
+    loot_rule_data_t const* only_rule() const noexcept;
+
+    //--------------------------------------------------------------------------
+    //! For each rule calls function(loot_rule_data_t const&).
+    //--------------------------------------------------------------------------
+    template <typename Function>
+    void for_each_rule(Function&& function) const {
+        for (auto const& rule : rules_) {
+            function(rule);
+        }
+    }
+
+    //--------------------------------------------------------------------------
+    //! For each table_ref rule calls function(loot_table_def_id).
+    //--------------------------------------------------------------------------
+    template <typename Function>
+    void for_each_reference(Function&& function) const {
+        for (auto const& rule : rules_) {
+            if (rule.id_type == loot_rule_data_t::id_t::table_ref) {
+                function(loot_table_def_id {rule.id});
+            }
+        }
+    }
 
     //--------------------------------------------------------------------------
     void set_id(string_ref const id_str, loot_table_def_id const id);
@@ -152,26 +283,128 @@ private:
     void tranform_data_();
 
     //--------------------------------------------------------------------------
-    void roll_all_(random_t& gen, defs_t defs, write_t const& write) const;
-    
+    template <typename Sink>
+    void expect_(defs_t defs, Sink& sink) const;
+
     //--------------------------------------------------------------------------
-    void choose_one_(random_t& gen, defs_t defs, write_t const& write) const;
+    template <typename Sink>
+    void roll_all_(random_t& gen, defs_t defs, Sink& sink) const {
+        auto const size = rules_.size();
+
+        for (size_t i = 0; i < size; ++i) {
+            auto const num = roll_data_[i*2 + 0];
+            auto const den = roll_data_[i*2 + 1];
+
+            auto const lo = static_cast<uint16_t>(0);
+            auto const hi = static_cast<uint16_t>(den - 1);
+
+            auto const roll = random::uniform_range(gen, lo, hi);
+            if (roll < num) {
+                roll_one_(gen, defs, rules_[i], sink);
+            }
+        }
+    }
 
     //--------------------------------------------------------------------------
-    void roll_one_(random_t& gen, defs_t defs, rule_t rule, write_t const& write) const;
+    template <typename Sink>
+    void choose_one_(random_t& gen, defs_t defs, Sink& sink) const {
+        roll_one_(gen, defs, rules_[alias_(gen)], sink);
+    }
 
     //--------------------------------------------------------------------------
-    void roll_one_item_(random_t& gen, rule_t rule, write_t const& write) const;
+    template <typename Sink>
+    void roll_one_(random_t& gen, defs_t defs, rule_t rule, Sink& sink) const {
+        using id_t = loot_rule_data_t::id_t;
+
+        if (rule.id_type == id_t::item_ref) {
+            roll_one_item_(gen, rule, sink);
+        } else if (rule.id_type == id_t::table_ref) {
+            roll_one_table_(gen, defs, rule, sink);
+        } else {
+            BK_TODO_FAIL();
+        }
+    }
 
     //--------------------------------------------------------------------------
-    void roll_one_table_(random_t& gen, defs_t defs, rule_t rule, write_t const& write) const;
+    template <typename Sink>
+    void roll_one_item_(random_t& gen, rule_t rule, Sink& sink) const {
+        BK_ASSERT_DBG(rule.id_type == loot_rule_data_t::id_t::item_ref);
+
+        auto const id = item_def_id {rule.id};
+        auto const n  = random::uniform_range(gen, rule.count_lo, rule.count_hi);
+
+        if (n > 0) {
+            sink(id, n);
+        }
+    }
+
+    //--------------------------------------------------------------------------
+    template <typename Sink>
+    void roll_one_table_(random_t& gen, defs_t defs, rule_t rule, Sink& sink) const {
+        BK_ASSERT_DBG(rule.id_type == loot_rule_data_t::id_t::table_ref);
+        BK_ASSERT_DBG(linked_);
+
+        auto const n = random::uniform_range(gen, rule.count_lo, rule.count_hi);
+
+        auto const& table = defs[rule.table];
+
+        for (uint16_t i = 0; i < n; ++i) {
+            table.generate(gen, defs, sink);
+        }
+    }
 
     //--------------------------------------------------------------------------
-    std::vector<uint16_t>         roll_data_;
+    std::vector<uint16_t>         roll_data_; //!< weights, or pairs of [num, den].
+    random::alias_table           alias_;     //!< built from roll_data_ for choose_one.
     std::vector<loot_rule_data_t> rules_;
     utf8string                    id_string_;
     loot_table_def_id             id_;
     roll_t                        type_;
+    bool                          linked_ = false;
+};
+
+//==============================================================================
+//! The results of many rolls kept in one flat buffer, with the results of
+//! each roll contiguous and in the order they were rolled.
+//==============================================================================
+class loot_batch {
+public:
+    //! Remove every roll, keeping the memory for reuse.
+    void clear() noexcept {
+        results_.clear();
+        offsets_.clear();
+    }
+
+    //! The number of rolls.
+    size_t size()  const noexcept { return offsets_.size(); }
+    bool   empty() const noexcept { return offsets_.empty(); }
+
+    //! The number of results across every roll.
+    size_t result_count() const noexcept { return results_.size(); }
+
+    //! The number of rolls, and of results, that fit without allocating.
+    size_t roll_capacity()   const noexcept { return offsets_.capacity(); }
+    size_t result_capacity() const noexcept { return results_.capacity(); }
+
+    //! The results of roll @p i as [roll_begin(i), roll_end(i)).
+    loot_result_t const* roll_begin(size_t const i) const noexcept {
+        BK_ASSERT_DBG(i < size());
+        return results_.data() + offsets_[i];
+    }
+
+    loot_result_t const* roll_end(size_t const i) const noexcept {
+        BK_ASSERT_DBG(i < size());
+        return results_.data() + ((i + 1 < size()) ? offsets_[i + 1] : results_.size());
+    }
+
+    //! Every result of every roll.
+    auto begin() const noexcept { return results_.begin(); }
+    auto end()   const noexcept { return results_.end(); }
+private:
+    friend loot_table;
+
+    std::vector<loot_result_t> results_;
+    std::vector<uint32_t>      offsets_; //!< index of the first result of each roll.
 };
 
 //==============================================================================
@@ -37,6 +37,7 @@ enum class message_type : uint16_t {
   , get_no_items
   , get_which_prompt
   , get_ok
+  , get_all_ok
 
   , drop_nothing
   , drop_ok
@@ -52,6 +53,7 @@ enum class message_type : uint16_t {
   , title_take_off
 
   , inventory_nothing
+  , inventory_weight
   
   , take_off_nothing
   , take_off_ok
@@ -92,6 +94,8 @@ enum class message_type : uint16_t {
   , itype_armor
   , itype_potion
 
+  , debug_sim_stats
+
   , enum_size
 };
 
@@ -6,10 +6,13 @@
 //##############################################################################
 #pragma once
 
+#include <array>
 #include <random>
+#include <vector>
 #include <boost/random/mersenne_twister.hpp>
 #include <boost/random/uniform_int_distribution.hpp>
 #include <boost/random/normal_distribution.hpp>
+#include <boost/random/uniform_01.hpp>
 
 #include "math.hpp"
 
@@ -22,10 +25,262 @@ inline uint32_t true_random() {
     return std::random_device {}();
 }
 
-class generator : public boost::mt19937 {
+//==============================================================================
+//! xoshiro256** (Blackman and Vigna); a fast generator with only 32 bytes of
+//! state, seeded from a single value by splitmix64 as its authors recommend.
+//==============================================================================
+class xoshiro256ss {
 public:
-    explicit generator(uint32_t const seed)
-      : boost::mt19937 {seed}
+    using result_type = uint64_t;
+    using state_type  = std::array<uint64_t, 4>;
+
+    static constexpr result_type min() noexcept { return 0; }
+    static constexpr result_type max() noexcept { return ~result_type {0}; }
+
+    explicit xoshiro256ss(uint64_t const value = 0) noexcept {
+        seed(value);
+    }
+
+    void seed(uint64_t value) noexcept {
+        for (auto& s : state_) {
+            value += 0x9E3779B97F4A7C15ull;
+
+            auto z = value;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            s = (z ^ (z >> 31));
+        }
+    }
+
+    result_type operator()() noexcept {
+        auto& s = state_;
+
+        auto const result = rotl_(s[1] * 5, 7) * 9;
+        auto const t      = s[1] << 17;
+
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3]  = rotl_(s[3], 45);
+
+        return result;
+    }
+
+    void discard(unsigned long long n) noexcept {
+        for (; n > 0; --n) {
+            (*this)();
+        }
+    }
+
+    //--------------------------------------------------------------------------
+    //! Advance by 2^128 values; equivalent to that many calls, and so a way to
+    //! make up to 2^128 non-overlapping streams from one seed.
+    //--------------------------------------------------------------------------
+    void jump() noexcept {
+        static constexpr uint64_t polynomial[] = {
+            0x180EC6D33CFD0ABAull, 0xD5A61266F0C9392Cull
+          , 0xA9582618E03FC9AAull, 0x39ABDC4529B1661Cull
+        };
+
+        state_type result {};
+
+        for (auto const p : polynomial) {
+            for (int bit = 0; bit < 64; ++bit) {
+                if (p & (uint64_t {1} << bit)) {
+                    for (size_t i = 0; i < result.size(); ++i) {
+                        result[i] ^= state_[i];
+                    }
+                }
+
+                (*this)();
+            }
+        }
+
+        state_ = result;
+    }
+
+    state_type state() const noexcept { return state_; }
+
+    void restore(state_type const& state) noexcept {
+        BK_ASSERT_DBG(state[0] || state[1] || state[2] || state[3]);
+        state_ = state;
+    }
+private:
+    static uint64_t rotl_(uint64_t const x, int const k) noexcept {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    state_type state_;
+};
+
+//==============================================================================
+//! Philox4x32-10 (Salmon et al., "Parallel Random Numbers: As Easy as 1, 2,
+//! 3"); a counter based generator.
+//!
+//! The n-th value of a stream is a pure function of its key and n, so a stream
+//! can skip ahead in constant time, and derive splits off independent streams
+//! keyed by a level, an entity, a room and so on. Each of those gives the same
+//! values whichever order, or thread, they end up being used in.
+//==============================================================================
+class philox4x32 {
+public:
+    using result_type = uint32_t;
+    using block_t     = std::array<uint32_t, 4>;
+    using key_t       = std::array<uint32_t, 2>;
+
+    //! everything needed to resume a stream.
+    struct state_type {
+        key_t    key;
+        uint64_t position;
+    };
+
+    static constexpr result_type min() noexcept { return 0; }
+    static constexpr result_type max() noexcept { return ~result_type {0}; }
+
+    explicit philox4x32(uint64_t const key = 0) noexcept {
+        seed(key);
+    }
+
+    void seed(uint64_t const key) noexcept {
+        key_      = key_t {{lo_(key), hi_(key)}};
+        position_ = 0;
+        cached_   = no_block;
+    }
+
+    result_type operator()() noexcept {
+        auto const b = position_ / 4;
+        if (b != cached_) {
+            block_  = block(key_, block_t {{lo_(b), hi_(b), 0, 0}});
+            cached_ = b;
+        }
+
+        return block_[position_++ % 4];
+    }
+
+    //! Skip the next @p n values in constant time.
+    void discard(unsigned long long const n) noexcept {
+        position_ += n;
+    }
+
+    //! The number of values drawn (or discarded) so far.
+    uint64_t position() const noexcept { return position_; }
+
+    state_type state() const noexcept { return state_type {key_, position_}; }
+
+    void restore(state_type const& state) noexcept {
+        key_      = state.key;
+        position_ = state.position;
+        cached_   = no_block;
+    }
+
+    //--------------------------------------------------------------------------
+    //! An independent stream for @p stream_key; the result only depends on
+    //! this stream's key and @p stream_key, not on how much has been drawn.
+    //--------------------------------------------------------------------------
+    philox4x32 derive(uint64_t const stream_key) const noexcept {
+        //the upper half of the counter is never used for drawing values.
+        auto const b = block(key_, block_t {{lo_(stream_key), hi_(stream_key), ~0u, ~0u}});
+
+        philox4x32 result;
+        result.key_ = key_t {{b[0], b[1]}};
+
+        return result;
+    }
+
+    //--------------------------------------------------------------------------
+    //! The 10 round Philox bijection of @p counter under @p key.
+    //--------------------------------------------------------------------------
+    static block_t block(key_t const key, block_t const counter) noexcept {
+        auto c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+        auto k0 = key[0],     k1 = key[1];
+
+        for (int round = 0; round < 10; ++round) {
+            auto const p0 = uint64_t {0xD2511F53u} * c0;
+            auto const p1 = uint64_t {0xCD9E8D57u} * c2;
+
+            c0 = hi_(p1) ^ c1 ^ k0;
+            c1 = lo_(p1);
+            c2 = hi_(p0) ^ c3 ^ k1;
+            c3 = lo_(p0);
+
+            k0 += 0x9E3779B9u;
+            k1 += 0xBB67AE85u;
+        }
+
+        return block_t {{c0, c1, c2, c3}};
+    }
+private:
+    static constexpr uint64_t no_block = ~uint64_t {0};
+
+    static uint32_t lo_(uint64_t const n) noexcept { return static_cast<uint32_t>(n); }
+    static uint32_t hi_(uint64_t const n) noexcept { return static_cast<uint32_t>(n >> 32); }
+
+    key_t    key_;
+    block_t  block_;
+    uint64_t position_ = 0;
+    uint64_t cached_   = no_block; //!< the block index held in block_.
+};
+
+namespace detail {
+//------------------------------------------------------------------------------
+//! How the state of an Engine is captured for basic_generator::snapshot; by
+//! default the engine's own state() and restore().
+//------------------------------------------------------------------------------
+template <typename Engine>
+struct engine_state {
+    using type = typename Engine::state_type;
+
+    static type capture(Engine const& engine) noexcept {
+        return engine.state();
+    }
+
+    static void restore(Engine& engine, type const& state, uint32_t, uint64_t) noexcept {
+        engine.restore(state);
+    }
+};
+
+//------------------------------------------------------------------------------
+//! The Mersenne Twister's 2.5 KB of state isn't worth keeping; it is rebuilt
+//! from the seed by discarding the values drawn since, which is linear in
+//! the count.
+//------------------------------------------------------------------------------
+template <>
+struct engine_state<boost::mt19937> {
+    struct type {};
+
+    static type capture(boost::mt19937 const&) noexcept {
+        return type {};
+    }
+
+    static void restore(boost::mt19937& engine, type, uint32_t const seed, uint64_t const count) {
+        engine.seed(seed);
+        engine.discard(count);
+    }
+};
+} //namespace detail
+
+//==============================================================================
+//! A seeded Engine that counts the values drawn from it.
+//==============================================================================
+template <typename Engine>
+class basic_generator : public Engine {
+public:
+    using engine_type = Engine;
+
+    //--------------------------------------------------------------------------
+    //! Everything needed to resume drawing from a generator exactly where it
+    //! was; small enough to keep in a save or a replay.
+    //--------------------------------------------------------------------------
+    struct snapshot_t {
+        uint32_t seed;
+        uint64_t count;
+        typename detail::engine_state<Engine>::type engine;
+    };
+
+    explicit basic_generator(uint32_t const seed)
+      : Engine {seed}
       , count_ {0}
       , seed_ {seed}
     {
@@ -33,29 +288,86 @@ public:
 
     auto operator()() noexcept {
         ++count_;
-        return boost::mt19937::operator()();
+        return Engine::operator()();
+    }
+
+    void seed(uint32_t const value) {
+        Engine::seed(value);
+        count_ = 0;
+        seed_  = value;
+    }
+
+    void discard(unsigned long long const n) {
+        Engine::discard(n);
+        count_ += n;
     }
 
     uint32_t get_seed() const noexcept {
         return seed_;
     }
+
+    //! The number of values drawn (or discarded) since seeding.
+    uint64_t count() const noexcept {
+        return count_;
+    }
+
+    snapshot_t snapshot() const noexcept {
+        return snapshot_t {seed_, count_, detail::engine_state<Engine>::capture(*this)};
+    }
+
+    void restore(snapshot_t const& snapshot) {
+        detail::engine_state<Engine>::restore(*this, snapshot.engine, snapshot.seed, snapshot.count);
+
+        seed_  = snapshot.seed;
+        count_ = snapshot.count;
+    }
 private:
-    uint32_t count_;
+    uint64_t count_;
     uint32_t seed_;
 };
 
-template <typename T>
-inline T uniform_range(generator& gen, T const lo, T const hi) {
+//------------------------------------------------------------------------------
+//! The engine behind generator; define BK_RANDOM_ENGINE_MT19937 to go back to
+//! the (much larger and slower) Mersenne Twister. Either is deterministic for
+//! a given seed, but they produce different sequences.
+//------------------------------------------------------------------------------
+#if defined(BK_RANDOM_ENGINE_MT19937)
+using default_engine = boost::mt19937;
+#else
+using default_engine = xoshiro256ss;
+#endif
+
+class generator : public basic_generator<default_engine> {
+public:
+    using basic_generator::basic_generator;
+};
+
+//------------------------------------------------------------------------------
+//! Derive the seed for an independent stream from @p seed and @p key; the
+//! result only depends on the two values (splitmix64 finalizer).
+//------------------------------------------------------------------------------
+inline uint32_t derive_seed(uint32_t const seed, uint64_t const key) noexcept {
+    auto z = key + (static_cast<uint64_t>(seed) + 1) * 0x9E3779B97F4A7C15ull;
+
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    z = (z ^ (z >> 31));
+
+    return static_cast<uint32_t>(z >> 32);
+}
+
+template <typename T, typename Generator>
+inline T uniform_range(Generator& gen, T const lo, T const hi) {
     return boost::random::uniform_int_distribution<T> {lo, hi}(gen);
 }
 
-template <typename T>
-inline T uniform_range(generator& gen, range<T> const r) {
+template <typename T, typename Generator>
+inline T uniform_range(Generator& gen, range<T> const r) {
     return uniform_range(gen, r.lo, r.hi);
 }
 
-template <typename T = int>
-inline vector2d<T> direction(generator& gen) {
+template <typename T = int, typename Generator>
+inline vector2d<T> direction(Generator& gen) {
     constexpr T value[] = {-1, 1};
     
     constexpr auto min = T {0};
@@ -67,16 +379,16 @@ inline vector2d<T> direction(generator& gen) {
     return {value[xi], value[yi]};
 }
 
-template <typename T = int>
-inline T percent(generator& gen) {
+template <typename T = int, typename Generator>
+inline T percent(Generator& gen) {
     constexpr auto min = T {0};
     constexpr auto max = T {100};
 
     return uniform_range<T>(gen, min, max);
 }
 
-template <typename T>
-inline T roll_dice(generator& gen, T const count, T const sides, T const mod) {
+template <typename T, typename Generator>
+inline T roll_dice(Generator& gen, T const count, T const sides, T const mod) {
     auto result = mod;
     
     for (auto i = T {0}; i < count; ++i) {
@@ -127,7 +439,8 @@ struct random_dist {
         new (&data.normal.dist) normal_dist {mean, sigma};
     }
 
-    int operator()(generator& gen) const {
+    template <typename Generator>
+    int operator()(Generator& gen) const {
         switch (type) {
         default :
         case dist_type::none :
@@ -150,6 +463,43 @@ struct random_dist {
         BK_TODO_FAIL();
     }
 
+    //--------------------------------------------------------------------------
+    //! Assign an independent sample to each element of the range @p out. The
+    //! distribution is the same as assigning operator() to each, but the type
+    //! is only dispatched on once, and dice take one roll per sample rather
+    //! than one per die, so the values drawn differ from those of as many
+    //! calls with the same generator. Normal samples are still drawn one at a
+    //! time.
+    //--------------------------------------------------------------------------
+    template <typename Generator, typename Range>
+    void sample_all(Generator& gen, Range&& out) const {
+        using std::begin;
+        using std::end;
+
+        auto const first = begin(out);
+        auto const last  = end(out);
+
+        switch (type) {
+        default :
+        case dist_type::none :
+            break;
+        case dist_type::constant :
+            std::fill(first, last, data.constant.value);
+            return;
+        case dist_type::uniform :
+            sample_uniform_(gen, first, last);
+            return;
+        case dist_type::dice :
+            sample_dice_(gen, first, last);
+            return;
+        case dist_type::normal :
+            sample_normal_(gen, first, last);
+            return;
+        }
+
+        BK_TODO_FAIL();
+    }
+
     explicit operator bool() const {
         return type != none;
     }
@@ -184,6 +534,181 @@ struct random_dist {
         union_t() : dummy (0) {}
     } data;
 #pragma warning( default : 4582 )
+private:
+    //--------------------------------------------------------------------------
+    template <typename Generator, typename OutIt>
+    void sample_uniform_(Generator& gen, OutIt first, OutIt const last) const {
+        boost::random::uniform_int_distribution<int> dist {data.uniform.lo, data.uniform.hi};
+
+        for (; first != last; ++first) {
+            *first = dist(gen);
+        }
+    }
+
+    //--------------------------------------------------------------------------
+    //! Each of the sides^count outcomes of rolling all the dice is equally
+    //! likely, so rather than rolling each die, one roll picks an outcome and
+    //! its digits (base sides) are the faces.
+    //--------------------------------------------------------------------------
+    template <typename Generator, typename OutIt>
+    void sample_dice_(Generator& gen, OutIt first, OutIt const last) const {
+        auto const& d = data.dice;
+
+        auto const sides    = static_cast<uint64_t>(d.sides);
+        auto       outcomes = uint64_t {1};
+
+        for (int i = 0; i < d.count && outcomes <= 0xFFFFFFFFull; ++i) {
+            outcomes *= sides;
+        }
+
+        //too many to pick from with a single 32 bit roll
+        if (outcomes > 0x100000000ull) {
+            for (; first != last; ++first) {
+                *first = roll_dice(gen, d.count, d.sides, d.mod);
+            }
+
+            return;
+        }
+
+        boost::random::uniform_int_distribution<uint32_t> dist {
+            0, static_cast<uint32_t>(outcomes - 1)
+        };
+
+        auto const s = static_cast<uint32_t>(d.sides);
+
+        for (; first != last; ++first) {
+            auto roll   = dist(gen);
+            auto result = d.count + d.mod; //faces are 1 based
+
+            for (int j = 0; j < d.count; ++j) {
+                result += static_cast<int>(roll % s);
+                roll   /= s;
+            }
+
+            *first = result;
+        }
+    }
+
+    //--------------------------------------------------------------------------
+    template <typename Generator, typename OutIt>
+    void sample_normal_(Generator& gen, OutIt first, OutIt const last) const {
+        auto const& d = data.normal;
+
+        //a copy; boost's ziggurat keeps no state between samples.
+        normal_dist dist {d.dist.mean(), d.dist.sigma()};
+
+        for (; first != last; ++first) {
+            *first = clamp(static_cast<int>(std::round(dist(gen))), d.min, d.max);
+        }
+    }
+};
+
+//==============================================================================
+//! Chooses an index in [0, size()) with a probability proportional to its
+//! (integer) weight in constant time; Vose's alias method.
+//!
+//! Built with integer arithmetic only, so each index is chosen with a
+//! probability of exactly weight / total(), as with a roll against the
+//! cumulative weights; a choice costs one roll regardless of size().
+//==============================================================================
+class alias_table {
+public:
+    alias_table() = default;
+
+    template <typename Range>
+    explicit alias_table(Range const& weights) {
+        build(weights);
+    }
+
+    //--------------------------------------------------------------------------
+    //! @pre the weights sum to more than 0, and size * sum fits in 32 bits.
+    //--------------------------------------------------------------------------
+    template <typename Range>
+    void build(Range const& weights) {
+        using std::begin;
+        using std::end;
+
+        auto const n = static_cast<uint32_t>(std::distance(begin(weights), end(weights)));
+
+        uint64_t total = 0;
+        for (auto const w : weights) {
+            total += static_cast<uint64_t>(w);
+        }
+
+        BK_ASSERT(n > 0 && total > 0);
+        BK_ASSERT(total * n <= 0xFFFFFFFFull);
+
+        total_ = static_cast<uint32_t>(total);
+        prob_.assign(n, total_);
+        alias_.resize(n);
+
+        //weights scaled by n, so that the average column holds exactly total_
+        std::vector<uint32_t> scaled;
+        scaled.reserve(n);
+        for (auto const w : weights) {
+            scaled.push_back(static_cast<uint32_t>(w) * n);
+        }
+
+        std::vector<uint32_t> small;
+        std::vector<uint32_t> large;
+
+        for (uint32_t i = 0; i < n; ++i) {
+            alias_[i] = i;
+            (scaled[i] < total_ ? small : large).push_back(i);
+        }
+
+        //fill each under full column from an over full one; the total is
+        //conserved exactly, so both run out at the same time.
+        while (!small.empty() && !large.empty()) {
+            auto const s = small.back();
+            auto const l = large.back();
+
+            small.pop_back();
+
+            prob_[s]  = scaled[s];
+            alias_[s] = l;
+
+            scaled[l] -= total_ - scaled[s];
+
+            if (scaled[l] < total_) {
+                large.pop_back();
+                small.push_back(l);
+            }
+        }
+
+        BK_ASSERT_DBG(small.empty());
+    }
+
+    size_t   size()  const noexcept { return prob_.size(); }
+    bool     empty() const noexcept { return prob_.empty(); }
+    uint32_t total() const noexcept { return total_; }
+
+    //! The number of distinct rolls; see choose.
+    uint32_t roll_count() const noexcept {
+        return static_cast<uint32_t>(size()) * total_;
+    }
+
+    //--------------------------------------------------------------------------
+    //! The index for @p roll in [0, roll_count()); one roll picks both the
+    //! column and the point within it. Exactly weight * size() rolls map to
+    //! each index.
+    //--------------------------------------------------------------------------
+    size_t choose(uint32_t const roll) const noexcept {
+        BK_ASSERT_DBG(roll < roll_count());
+
+        auto const i = roll / total_;
+        return (roll % total_ < prob_[i]) ? i : alias_[i];
+    }
+
+    template <typename Generator>
+    size_t operator()(Generator& gen) const {
+        BK_ASSERT_DBG(!empty());
+        return choose(uniform_range(gen, uint32_t {0}, roll_count() - 1));
+    }
+private:
+    std::vector<uint32_t> prob_;  //!< out of total_; the chance of keeping i.
+    std::vector<uint32_t> alias_; //!< the index chosen otherwise.
+    uint32_t              total_ = 0;
 };
 
 using range_generator = std::function<unsigned (unsigned lo, unsigned hi)>;
@@ -0,0 +1,242 @@
+//##############################################################################
+//! @file
+//! @author Brandon Kentel
+//!
+//! Speed (energy) based turn scheduling.
+//##############################################################################
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+
+#include "integers.hpp"
+#include "identifier.hpp"
+#include "optional.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+namespace bkrl {
+////////////////////////////////////////////////////////////////////////////////
+
+using speed_t = int16_t;
+
+//==============================================================================
+//! Orders entities by the game time at which they next get to act.
+//!
+//! Time is measured in ticks; one turn at speed_normal lasts turn_length ticks.
+//! Faster entities come due more often, slower ones less often. Only entities
+//! that are actually due are visited, and sleeping entities are not queued at
+//! all, so idle monsters cost nothing per turn.
+//==============================================================================
+class scheduler {
+public:
+    using time_t = uint64_t;
+
+    enum : time_t  { turn_length  = 100 };
+    enum : speed_t { speed_normal = 100, speed_min = 1 };
+
+    //! The number of ticks that @p turns turns take at @p speed.
+    static time_t delay_for(speed_t speed, int turns = 1) noexcept;
+
+    //--------------------------------------------------------------------------
+    //! Schedule @p id to act @p delay ticks from now. Rescheduling an entity
+    //! already in the queue replaces its previous entry.
+    //--------------------------------------------------------------------------
+    void insert(entity_id id, time_t delay);
+
+    //--------------------------------------------------------------------------
+    //! Remove @p id from the queue (i.e. it has died or fallen asleep).
+    //! @returns true if @p id was scheduled.
+    //--------------------------------------------------------------------------
+    bool remove(entity_id id);
+
+    bool is_scheduled(entity_id id) const;
+
+    optional<time_t> next_time(entity_id id) const;
+
+    time_t now() const noexcept { return now_; }
+
+    //! The number of entities currently scheduled.
+    size_t size() const noexcept { return index_.size(); }
+
+    bool empty() const noexcept { return index_.empty(); }
+
+    //--------------------------------------------------------------------------
+    //! Move the clock forward by @p delta ticks, invoking @p function for every
+    //! entity that comes due, in order of time and then of scheduling.
+    //!
+    //! @p function is invoked as time_t (entity_id) and returns the delay until
+    //! the entity's next action, or 0 to put it to sleep. It may freely insert
+    //! or remove other entities.
+    //!
+    //! @returns the number of entities that acted.
+    //--------------------------------------------------------------------------
+    template <typename Function>
+    size_t advance(time_t const delta, Function&& function) {
+        auto const until = now_ + delta;
+
+        size_t   count = 0;
+        record_t rec;
+
+        while (pop_due_(until, rec)) {
+            now_ = rec.time;
+            ++count;
+
+            auto const id    = slots_[rec.slot].id;
+            auto const delay = static_cast<time_t>(function(id));
+
+            if (delay) {
+                reinsert_(rec, delay);
+            } else if (is_live_(rec)) {
+                remove(id);
+            }
+        }
+
+        now_ = until;
+
+        return count;
+    }
+
+    //--------------------------------------------------------------------------
+    //! As advance, but the entities due at the same time are handed to
+    //! @p function at once; now() is that time. Batches are visited in order
+    //! of time, and each in order of scheduling, so the entities act in
+    //! exactly the order advance would visit them.
+    //!
+    //! @p function is invoked as void (ids, delays) where ids is a
+    //! std::vector<entity_id> const& and delays a std::vector<time_t>& of the
+    //! same size to be filled in with each entity's delay (0 to sleep).
+    //!
+    //! @returns the number of entities that acted.
+    //--------------------------------------------------------------------------
+    template <typename Function>
+    size_t advance_batched(time_t const delta, Function&& function) {
+        auto const until = now_ + delta;
+
+        size_t count = 0;
+
+        while (pop_all_due_(until)) {
+            now_   = batch_.front().time;
+            count += batch_.size();
+
+            batch_ids_.clear();
+            for (auto const& rec : batch_) {
+                batch_ids_.push_back(slots_[rec.slot].id);
+            }
+
+            batch_delays_.assign(batch_.size(), time_t {0});
+
+            function(batch_ids_, batch_delays_);
+
+            for (size_t i = 0; i < batch_.size(); ++i) {
+                auto const& rec   = batch_[i];
+                auto const  delay = batch_delays_[i];
+
+                if (delay) {
+                    reinsert_(rec, delay);
+                } else if (is_live_(rec)) {
+                    remove(batch_ids_[i]);
+                }
+            }
+        }
+
+        now_ = until;
+
+        return count;
+    }
+
+    //--------------------------------------------------------------------------
+    //! As advance_batched, but split into a parallel and a serial phase.
+    //!
+    //! For each batch, @p decide is first invoked as Intent (entity_id, time_t)
+    //! for every entity across @p pool (e.g. a thread_pool), and may be run
+    //! concurrently; the results go in @p intents. @p resolve is then invoked
+    //! as time_t (entity_id, Intent const&) for each entity in turn and
+    //! returns its delay as for advance.
+    //!
+    //! As long as @p decide depends only on its arguments and on state that
+    //! only @p resolve changes, the outcome doesn't depend on the pool's size.
+    //--------------------------------------------------------------------------
+    template <typename Pool, typename Intent, typename Decide, typename Resolve>
+    size_t advance_parallel(
+        time_t              const delta
+      , Pool&                     pool
+      , size_t              const min_chunk
+      , std::vector<Intent>&      intents
+      , Decide&&                  decide
+      , Resolve&&                 resolve
+    ) {
+        return advance_batched(delta, [&](
+            std::vector<entity_id> const& ids
+          , std::vector<time_t>&          delays
+        ) {
+            auto const n    = ids.size();
+            auto const time = now_;
+
+            intents.resize(n);
+
+            pool.parallel_for(n, min_chunk, [&](size_t const first, size_t const last) {
+                for (auto i = first; i < last; ++i) {
+                    intents[i] = decide(ids[i], time);
+                }
+            });
+
+            for (size_t i = 0; i < n; ++i) {
+                delays[i] = resolve(ids[i], intents[i]);
+            }
+        });
+    }
+private:
+    //! A (possibly stale) entry in the queue.
+    struct record_t {
+        time_t   time;
+        uint64_t ticket;
+        uint32_t slot;
+    };
+
+    //! The live state for a scheduled entity; records whose ticket doesn't
+    //! match their slot's are stale and are skipped when popped.
+    struct slot_t {
+        entity_id id;
+        uint64_t  ticket;
+        time_t    time;
+    };
+
+    struct later_t {
+        bool operator()(record_t const& lhs, record_t const& rhs) const noexcept {
+            return (lhs.time != rhs.time)
+              ? (lhs.time   > rhs.time)
+              : (lhs.ticket > rhs.ticket);
+        }
+    };
+
+    enum : uint64_t { free_ticket = ~uint64_t {0} };
+
+    bool is_live_(record_t const& rec) const noexcept {
+        return slots_[rec.slot].ticket == rec.ticket;
+    }
+
+    bool pop_due_(time_t until, record_t& out);
+    bool pop_all_due_(time_t until);
+    void reinsert_(record_t const& rec, time_t delay);
+    void push_(uint32_t slot, time_t time);
+    void compact_();
+
+    std::vector<record_t> heap_;
+    std::vector<slot_t>   slots_;
+    std::vector<uint32_t> free_slots_;
+
+    //! scratch space for advance_batched.
+    std::vector<record_t>  batch_;
+    std::vector<entity_id> batch_ids_;
+    std::vector<time_t>    batch_delays_;
+
+    //! entity id -> slot; only consulted when entities are added or removed.
+    std::unordered_map<uint32_t, uint32_t> index_;
+
+    time_t   now_         = 0;
+    uint64_t next_ticket_ = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+} //namespace bkrl
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,168 @@
+//##############################################################################
+//! @file
+//! @author Brandon Kentel
+//!
+//! Weighted, depth dependent tables of the entities that populate a room.
+//##############################################################################
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "assert.hpp"
+#include "identifier.hpp"
+#include "optional.hpp"
+#include "random.hpp"
+#include "json_forward.hpp"
+#include "string.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+namespace bkrl {
+////////////////////////////////////////////////////////////////////////////////
+
+class entity_definitions;
+class spawn_table;
+class spawn_table_definitions;
+
+namespace detail { class spawn_table_definitions_impl; }
+
+//==============================================================================
+//! a single weighted choice of entity for a range of depths.
+//==============================================================================
+struct spawn_rule_t {
+    //! depth_hi for a rule that applies to every depth from depth_lo on; not
+    //! a depth that can be given explicitly.
+    static constexpr uint16_t open_depth = 0xFFFF;
+
+    entity_def_id id;       //!< the entity spawned.
+    uint16_t      weight;   //!< relative to the other rules for the same depth.
+    uint16_t      depth_lo; //!< the shallowest depth the rule applies to.
+    uint16_t      depth_hi; //!< the deepest depth the rule applies to.
+};
+
+//==============================================================================
+//! collection of spawn tables; one per room type.
+//==============================================================================
+class spawn_table_definitions {
+public:
+    ~spawn_table_definitions();
+
+    spawn_table_definitions();
+    spawn_table_definitions(spawn_table_definitions&&);
+    spawn_table_definitions& operator=(spawn_table_definitions&&);
+
+    //--------------------------------------------------------------------------
+    void load_definitions(json::cref data);
+
+    //--------------------------------------------------------------------------
+    //! Resolve the entities of every table and build its per depth tables;
+    //! done once the entities are loaded. Tables can't be used before.
+    //--------------------------------------------------------------------------
+    void link(entity_definitions const& entity_defs);
+
+    //--------------------------------------------------------------------------
+    //! The table for @p id, or nullptr if there isn't one.
+    //--------------------------------------------------------------------------
+    spawn_table const* find(spawn_table_def_id id) const;
+
+    spawn_table const& operator[](spawn_table_def_id id) const;
+
+    //! The number of tables.
+    int size() const noexcept;
+private:
+    std::unique_ptr<detail::spawn_table_definitions_impl> impl_;
+};
+
+//==============================================================================
+//! the entities that can be spawned in one type of room, and how likely each
+//! is at a given depth.
+//!
+//! link compiles the rules into an alias table for each run of depths between
+//! the points where some rule starts or ends, so an entity is chosen with a
+//! binary search over those points and a single roll however many rules
+//! there are. Depths past the last such point all share the deepest table.
+//==============================================================================
+class spawn_table {
+public:
+    //--------------------------------------------------------------------------
+    spawn_table(spawn_table&&)                 = default;
+    spawn_table& operator=(spawn_table&&)      = default;
+    spawn_table(spawn_table const&)            = delete;
+    spawn_table& operator=(spawn_table const&) = delete;
+
+    //--------------------------------------------------------------------------
+    spawn_table() = default;
+
+    spawn_table(
+        string_ref                const id_str
+      , spawn_table_def_id        const id
+      , std::vector<spawn_rule_t>       rules
+    );
+
+    //--------------------------------------------------------------------------
+    //! Resolve each rule's entity to an index and build the per depth tables.
+    //--------------------------------------------------------------------------
+    void link(entity_definitions const& entity_defs);
+
+    bool is_linked() const noexcept { return linked_; }
+
+    //--------------------------------------------------------------------------
+    //! A random entity to spawn at @p depth, or nothing if no rule applies.
+    //! @pre is_linked()
+    //--------------------------------------------------------------------------
+    template <typename Generator>
+    optional<entity_def_index> operator()(Generator& gen, int const depth) const {
+        auto const& table = at_depth_(depth);
+        if (table.entities.empty()) {
+            return {};
+        }
+
+        return table.entities[table.alias(gen)];
+    }
+
+    //! The number of distinct runs of depths, each with its own table; see
+    //! operator().
+    int depth_count() const noexcept {
+        return static_cast<int>(depths_.size());
+    }
+
+    spawn_table_def_id id()        const noexcept { return id_; }
+    utf8string const&  id_string() const noexcept { return id_string_; }
+
+    //--------------------------------------------------------------------------
+    //! Invokes f(spawn_rule_t const&) for each rule in the table.
+    //--------------------------------------------------------------------------
+    template <typename Function>
+    void for_each_rule(Function&& f) const {
+        for (auto const& rule : rules_) {
+            f(rule);
+        }
+    }
+private:
+    struct depth_table_t {
+        random::alias_table           alias;
+        std::vector<entity_def_index> entities; //!< indexed by the alias table.
+    };
+
+    depth_table_t const& at_depth_(int const depth) const noexcept {
+        BK_ASSERT_DBG(linked_ && !depths_.empty());
+
+        //starts_ begins at 0, so anything shallower is in the first run.
+        auto const it = std::upper_bound(std::begin(starts_), std::end(starts_), depth);
+        auto const i  = std::max<ptrdiff_t>(it - std::begin(starts_), 1) - 1;
+
+        return depths_[static_cast<size_t>(i)];
+    }
+
+    std::vector<spawn_rule_t>  rules_;
+    std::vector<int>           starts_;  //!< the first depth of each run; set by link.
+    std::vector<depth_table_t> depths_;  //!< the table for each run; set by link.
+    utf8string                 id_string_;
+    spawn_table_def_id         id_     {0};
+    bool                       linked_ = false;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+} //namespace bkrl
+////////////////////////////////////////////////////////////////////////////////
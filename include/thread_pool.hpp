@@ -0,0 +1,54 @@
+//##############################################################################
+//! @file
+//! @author Brandon Kentel
+//!
+//! A simple fork / join pool of worker threads.
+//##############################################################################
+#pragma once
+
+#include <functional>
+#include <memory>
+
+////////////////////////////////////////////////////////////////////////////////
+namespace bkrl {
+////////////////////////////////////////////////////////////////////////////////
+
+namespace detail { class thread_pool_impl; }
+
+//==============================================================================
+//! A fixed set of worker threads used to split data parallel work into chunks.
+//!
+//! The calling thread takes part in the work and blocks until all of it is
+//! done. Which thread runs which chunk is unspecified; the work for each index
+//! must not depend on it.
+//==============================================================================
+class thread_pool {
+public:
+    //! invoked as function(first, last) for the half open range [first, last).
+    using chunk_function = std::function<void (size_t first, size_t last)>;
+
+    //--------------------------------------------------------------------------
+    //! @param threads The total number of threads to use, including the
+    //!                caller; 0 uses one per hardware thread.
+    //--------------------------------------------------------------------------
+    explicit thread_pool(unsigned threads = 0);
+    ~thread_pool();
+
+    thread_pool(thread_pool const&)            = delete;
+    thread_pool& operator=(thread_pool const&) = delete;
+
+    //! The total number of threads work is split across, including the caller.
+    unsigned size() const noexcept;
+
+    //--------------------------------------------------------------------------
+    //! Invoke @p function over [0, n) in chunks of at least @p min_chunk.
+    //! @pre not called from within @p function.
+    //--------------------------------------------------------------------------
+    void parallel_for(size_t n, size_t min_chunk, chunk_function const& function);
+private:
+    std::unique_ptr<detail::thread_pool_impl> impl_;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+} //namespace bkrl
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,124 @@
+#include "background_worker.hpp"
+#include "assert.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+//==============================================================================
+//!
+//==============================================================================
+class bkrl::detail::background_worker_impl {
+public:
+    using task = background_worker::task;
+
+    //--------------------------------------------------------------------------
+    background_worker_impl()
+      : thread_ {[this] { worker_(); }}
+    {
+    }
+
+    //--------------------------------------------------------------------------
+    ~background_worker_impl() {
+        {
+            std::lock_guard<std::mutex> lock {mutex_};
+            stop_ = true;
+        }
+
+        work_cv_.notify_one();
+        thread_.join();
+    }
+
+    //--------------------------------------------------------------------------
+    void post(task t) {
+        BK_ASSERT(!!t);
+
+        {
+            std::lock_guard<std::mutex> lock {mutex_};
+            tasks_.push_back(std::move(t));
+            ++pending_;
+        }
+
+        work_cv_.notify_one();
+    }
+
+    //--------------------------------------------------------------------------
+    bool is_idle() const {
+        std::lock_guard<std::mutex> lock {mutex_};
+        return pending_ == 0;
+    }
+
+    //--------------------------------------------------------------------------
+    void sync() {
+        BK_ASSERT(std::this_thread::get_id() != thread_.get_id());
+
+        std::unique_lock<std::mutex> lock {mutex_};
+        done_cv_.wait(lock, [&] { return pending_ == 0; });
+    }
+private:
+    //--------------------------------------------------------------------------
+    void worker_() {
+        for (;;) {
+            task t;
+
+            {
+                std::unique_lock<std::mutex> lock {mutex_};
+                work_cv_.wait(lock, [&] { return stop_ || !tasks_.empty(); });
+
+                //finish whatever is left before stopping.
+                if (tasks_.empty()) {
+                    return;
+                }
+
+                t = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+
+            t();
+
+            std::lock_guard<std::mutex> lock {mutex_};
+            if (--pending_ == 0) {
+                done_cv_.notify_all();
+            }
+        }
+    }
+
+    mutable std::mutex      mutex_;
+    std::condition_variable work_cv_;
+    std::condition_variable done_cv_;
+
+    std::deque<task> tasks_;
+    size_t           pending_ = 0; //!< queued or running
+    bool             stop_    = false;
+
+    std::thread thread_; //!< last; started once everything else is ready
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// background_worker
+////////////////////////////////////////////////////////////////////////////////
+
+//------------------------------------------------------------------------------
+bkrl::background_worker::background_worker()
+  : impl_ {std::make_unique<detail::background_worker_impl>()}
+{
+}
+
+//------------------------------------------------------------------------------
+bkrl::background_worker::~background_worker() = default;
+
+//------------------------------------------------------------------------------
+void bkrl::background_worker::post(task t) {
+    impl_->post(std::move(t));
+}
+
+//------------------------------------------------------------------------------
+bool bkrl::background_worker::is_idle() const {
+    return impl_->is_idle();
+}
+
+//------------------------------------------------------------------------------
+void bkrl::background_worker::sync() {
+    impl_->sync();
+}
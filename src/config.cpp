@@ -27,6 +27,8 @@ public:
         rule_window_pos(value);
         rule_font(value);
         rule_language(value);
+        rule_sim_radius(value);
+        rule_sim_interval(value);
     }
 
     //--------------------------------------------------------------------------
@@ -57,7 +59,7 @@ public:
 
     //--------------------------------------------------------------------------
     void rule_trivial_seed(cref value) {
-        config_.substantive_seed = get_seed(value[jc::field_trivial_seed]);
+        config_.trivial_seed = get_seed(value[jc::field_trivial_seed]);
     }
 
     //--------------------------------------------------------------------------
@@ -95,6 +97,39 @@ public:
         config_.language  = lang ? *lang : BK_MAKE_LANG_CODE2('e','n');
     }
 
+    //--------------------------------------------------------------------------
+    void rule_sim_radius(cref value) {
+        if (!json::has_field(value, jc::field_sim_radius)) {
+            return;
+        }
+
+        cref radius = json::require_array(value[jc::field_sim_radius], 2, 2);
+
+        auto const full   = json::require_int<int>(radius[0]);
+        auto const coarse = json::require_int<int>(radius[1]);
+
+        if (full < 0 || coarse < full) {
+            BK_TODO_FAIL(); //throw bad radii
+        }
+
+        config_.sim_radius_full   = full;
+        config_.sim_radius_coarse = coarse;
+    }
+
+    //--------------------------------------------------------------------------
+    void rule_sim_interval(cref value) {
+        if (!json::has_field(value, jc::field_sim_interval)) {
+            return;
+        }
+
+        auto const interval = json::require_int<int>(value[jc::field_sim_interval]);
+        if (interval < 1) {
+            BK_TODO_FAIL(); //throw bad interval
+        }
+
+        config_.sim_interval = interval;
+    }
+
     //--------------------------------------------------------------------------
     operator config&&() && {
         return std::move(config_);
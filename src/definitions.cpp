@@ -29,6 +29,7 @@ bkrl::data_definitions::get_file_type(json::cref value) {
     static auto const hash_entitiy = slash_hash32(jc::filetype_entity);
     static auto const hash_keymap  = slash_hash32(jc::filetype_keymap);
     static auto const hash_loot    = slash_hash32(jc::filetype_loot);
+    static auto const hash_spawn   = slash_hash32(jc::filetype_spawn);
 
     auto const type = jc::get_filetype(value);
     auto const hash = slash_hash32(type);
@@ -40,6 +41,7 @@ bkrl::data_definitions::get_file_type(json::cref value) {
     else if (hash == hash_entitiy) { return filetype::entity; }
     else if (hash == hash_keymap)  { return filetype::keymap; }
     else if (hash == hash_loot)    { return filetype::loot_table; }
+    else if (hash == hash_spawn)   { return filetype::spawn_table; }
 
     return filetype::invalid;
 }
@@ -100,6 +102,11 @@ bkrl::data_definitions::load_loot_table(json::cref value) {
     loot_table_defs_.load_definitions(value);
 }
 
+void
+bkrl::data_definitions::load_spawn_table(json::cref value) {
+    spawn_table_defs_.load_definitions(value);
+}
+
 void
 bkrl::data_definitions::load_files() {
     for (auto const& filename : files_) {
@@ -107,15 +114,21 @@ bkrl::data_definitions::load_files() {
         auto const type  = get_file_type(value);
 
         switch (type) {
-        case filetype::config     : load_config(value);     break;
-        case filetype::locale     : load_locale(value);     break;
-        case filetype::texmap     : load_texmap(value);     break;
-        case filetype::item       : load_item(value);       break;
-        case filetype::entity     : load_entity(value);     break;
-        case filetype::keymap     : load_keymap(value);     break;
-        case filetype::loot_table : load_loot_table(value); break;
+        case filetype::config      : load_config(value);      break;
+        case filetype::locale      : load_locale(value);      break;
+        case filetype::texmap      : load_texmap(value);      break;
+        case filetype::item        : load_item(value);        break;
+        case filetype::entity      : load_entity(value);      break;
+        case filetype::keymap      : load_keymap(value);      break;
+        case filetype::loot_table  : load_loot_table(value);  break;
+        case filetype::spawn_table : load_spawn_table(value); break;
         }
     }
+
+    //tables can refer to each other (and entities to tables) across files.
+    loot_table_defs_.link();
+    entity_defs_.link(loot_table_defs_);
+    spawn_table_defs_.link(entity_defs_);
 }
 
 void
@@ -15,8 +15,13 @@
 #include "scope_exit.hpp"
 #include "definitions.hpp"
 #include "gui.hpp"
+#include "scheduler.hpp"
+#include "thread_pool.hpp"
+#include "background_worker.hpp"
 
 #include "loot_table.hpp"
+#include "spawn_table.hpp"
+#include "hash.hpp"
 
 #include <boost/container/static_vector.hpp>
 #include <boost/format.hpp>
@@ -320,10 +325,17 @@ struct tile_sheet_set {
 //==============================================================================
 class level {
 public:
+    //--------------------------------------------------------------------------
+    //! @param seed  Seeds the level's own stream, used for whatever happens on
+    //!              the level while the player is elsewhere.
+    //! @param depth How far down the level is; 0 for the first. Decides what
+    //!              spawns there.
     //--------------------------------------------------------------------------
     level(
         random::generator& substantive
       , random::generator& trivial
+      , uint32_t const     seed
+      , int const          depth
       , data_definitions const& definitions
       , item_store&        items
       , player&            player
@@ -333,11 +345,29 @@ public:
     )
       : definitions_  {&definitions}
       , item_store_   {&items}
+      , item_arena_   {items}
       , tiles_sheets_ {&tiles_sheets}
       , player_       {&player}
+      , random_       {seed}
+      , depth_        {depth}
       , grid_         {width, height}
+      , item_stacks_  {width, height}
     {
         generate_(substantive, trivial);
+
+        population_ = entities_.size();
+    }
+
+    //--------------------------------------------------------------------------
+    //! Whether the player is on this level. While the player is away the
+    //! level never looks at them; it can then be advanced on another thread.
+    //--------------------------------------------------------------------------
+    void set_player_present(bool const present) noexcept {
+        player_present_ = present;
+    }
+
+    bool is_player_present() const noexcept {
+        return player_present_;
     }
     
     ////////////////////////////////////////////////////////////////////////////
@@ -460,15 +490,8 @@ public:
     //! Draw all items on the level.
     //--------------------------------------------------------------------------
     void draw_items(renderer& r, tile_sheet& sheet) {
-        auto const& istore = *item_store_;
-        auto const& idefs  = definitions_->get_items();
-
-        items_.for_each_stack([&](ipoint2 const p, item_id const itm, int const n) {
-            auto const info = (n == 1)
-              ? istore[itm].render_info(idefs)
-              : idefs.get_stack_info(n);
-
-            sheet.render(r, info.tex_position, p);
+        item_stacks_.for_each_stack([&](item_stack_summary::stack_t const& s) {
+            sheet.render(r, s.info.tex_position, s.pos);
         });
     }
 
@@ -493,22 +516,67 @@ public:
     }
 
     //--------------------------------------------------------------------------
-    bool update_entity_(random::generator& trivial, entity& ent) {
+    //! What an entity intends to do this turn: the moves to try, in order,
+    //! until one succeeds.
+    //--------------------------------------------------------------------------
+    struct intent_t {
+        boost::container::static_vector<ivec2, 4> moves;
+    };
+
+    //--------------------------------------------------------------------------
+    //! Decide what @p ent wants to do. Only reads the level, so it is safe to
+    //! run for many entities concurrently; @p gen must be private to @p ent.
+    //--------------------------------------------------------------------------
+    intent_t decide_entity_(random::philox4x32& gen, entity const& ent) const {
         auto constexpr move_percent   = 25;
         auto constexpr sense_distance = 5;
 
-        auto const pos_self   = ent.position();
-        auto const pos_player = player_->position();
-        auto const delta      = pos_player - pos_self;
+        intent_t result;
+
+        //
+        // near player; only entities being fully simulated bother to look
+        //
+        auto const aware = player_present_ && ent.data.tier == sim_tier::full;
+        auto const delta = aware
+          ? player_->position() - ent.position()
+          : ivec2 {0, 0};
 
         auto const dx = std::abs(delta.x);
         auto const dy = std::abs(delta.y);
 
-        //BK_ASSERT_DBG(dx || dy);
+        if (aware && dx <= sense_distance && dy <= sense_distance) {
+            auto const ux = sign_of(delta.x);
+            auto const uy = sign_of(delta.y);
+
+            result.moves.push_back(ivec2 {ux, uy});
+            if (ux) { result.moves.push_back(ivec2 {ux,  0}); }
+            if (uy) { result.moves.push_back(ivec2 { 0, uy}); }
+        }
+
+        //
+        // otherwise move randomly
+        //
+        auto const roll = random::percent(gen);
+        if (roll < move_percent) {
+            return result;
+        }
 
-        // after trying to move, decide what to do
-        auto const on_move = [](move_result const m) {
-            switch (m) {
+        auto v = random::direction(gen);
+        while (!(v.x || v.y)) {
+            v = random::direction(gen);
+        }
+
+        result.moves.push_back(v);
+
+        return result;
+    }
+
+    //--------------------------------------------------------------------------
+    //! Carry out the intent decided for @p ent.
+    //--------------------------------------------------------------------------
+    bool resolve_entity_(entity& ent, intent_t const& intent) {
+        for (auto const v : intent.moves) {
+            switch (try_move(ent, v)) {
             case move_result::ok:
                 return true;
             case move_result::blocked_bounds:
@@ -521,54 +589,240 @@ public:
             default:
                 break;
             }
+        }
 
-            return false;
-        };
+        return false;
+    }
 
-        //
-        // near player
-        //
-        if (dx <= sense_distance && dy <= sense_distance) {
-            auto const ux = sign_of(delta.x);
-            auto const uy = sign_of(delta.y);
+    //--------------------------------------------------------------------------
+    //! The number of entities in each simulation tier; see advance.
+    //--------------------------------------------------------------------------
+    struct sim_stats_t {
+        int full   = 0; //!< act at their own speed.
+        int coarse = 0; //!< act once every config::sim_interval turns.
+        int frozen = 0; //!< don't act at all.
+        int acted  = 0; //!< entities that acted during the last turn.
+        int thawed = 0; //!< frozen entities caught up during the last turn.
+    };
 
-            auto result = on_move(try_move(ent, ivec2 {ux, uy}))
-                 || ux && on_move(try_move(ent, ivec2 {ux,  0}))
-                 || uy && on_move(try_move(ent, ivec2 { 0, uy}));
+    sim_stats_t const& sim_stats() const noexcept {
+        return sim_stats_;
+    }
 
-            if (result) {
-                return true;
+    //--------------------------------------------------------------------------
+    //! The tier an entity at @p p belongs in given the player's position.
+    //! With the player away, everything just wanders.
+    //--------------------------------------------------------------------------
+    sim_tier tier_at_(ipoint2 const p) const noexcept {
+        if (!player_present_) {
+            return sim_tier::coarse;
+        }
+
+        auto const& cfg = definitions_->get_config();
+
+        auto const v = player_->position() - p;
+        auto const d = std::max(std::abs(v.x), std::abs(v.y));
+
+        return (d <= cfg.sim_radius_full)   ? sim_tier::full
+             : (d <= cfg.sim_radius_coarse) ? sim_tier::coarse
+             :                                sim_tier::frozen;
+    }
+
+    //--------------------------------------------------------------------------
+    int& tier_count_(sim_tier const tier) noexcept {
+        switch (tier) {
+        case sim_tier::full   : return sim_stats_.full;
+        case sim_tier::coarse : return sim_stats_.coarse;
+        case sim_tier::frozen : break;
+        }
+
+        return sim_stats_.frozen;
+    }
+
+    //--------------------------------------------------------------------------
+    void set_tier_(entity& ent, sim_tier const tier) noexcept {
+        --tier_count_(ent.data.tier);
+        ++tier_count_(tier);
+
+        ent.data.tier = tier;
+    }
+
+    //--------------------------------------------------------------------------
+    //! Move @p ent to where it might plausibly have wandered to during the
+    //! @p turns turns it was frozen.
+    //!
+    //! Every turn an unaware entity takes a diagonal step with probability
+    //! ~3/4 (see decide_entity_), so after n turns its displacement along each
+    //! axis is roughly normal with a variance of 3n/4. A displacement is drawn
+    //! from that and shortened until it lands somewhere the entity can stand.
+    //--------------------------------------------------------------------------
+    void catch_up_(random::philox4x32& gen, entity& ent, scheduler::time_t const turns) {
+        auto constexpr move_variance = 0.75;
+
+        if (turns == 0) {
+            return;
+        }
+
+        auto const sigma = std::sqrt(move_variance * static_cast<double>(turns));
+        random::normal_dist dist {0.0, sigma};
+
+        auto const dx = static_cast<int>(std::lround(dist(gen)));
+        auto const dy = static_cast<int>(std::lround(dist(gen)));
+
+        auto const steps = std::max(std::abs(dx), std::abs(dy));
+        auto const p     = ent.position();
+
+        for (auto i = steps; i > 0; --i) {
+            auto const q = p + ivec2 {dx * i / steps, dy * i / steps};
+
+            if (can_move_to(ent, q) == move_result::ok) {
+                ent.move_to(q);
+                return;
             }
         }
+    }
 
-        //
-        // move randomly
-        //
-        auto const roll = random::percent(trivial);
-        if (roll < move_percent) {
-            return false;
+    //--------------------------------------------------------------------------
+    //! Wake up the frozen entities the player has come close enough to.
+    //--------------------------------------------------------------------------
+    void thaw_entities_(uint32_t const seed) {
+        auto const now = scheduler_.now();
+
+        auto const it = std::partition(std::begin(frozen_), std::end(frozen_)
+          , [&](frozen_t const& f) {
+                auto still_frozen = true;
+
+                entities_.with_entity(f.id, [&](entity const& ent) {
+                    still_frozen = tier_at_(ent.position()) == sim_tier::frozen;
+                });
+
+                return still_frozen;
+            }
+        );
+
+        thawed_.assign(it, std::end(frozen_));
+        frozen_.erase(it, std::end(frozen_));
+
+        auto const streams = random::philox4x32 {seed}.derive(now);
+
+        for (auto const& f : thawed_) {
+            entities_.with_entity(f.id, [&](entity& ent) {
+                auto gen = streams.derive(id_to_value(f.id));
+
+                catch_up_(gen, ent, (now - f.since) / scheduler::turn_length);
+                set_tier_(ent, sim_tier::full);
+            });
+
+            //let it settle into its proper tier the first time it acts.
+            scheduler_.insert(f.id, scheduler::turn_length);
         }
 
-        auto v = random::direction(trivial);
-        while (!(v.x || v.y)) {
-            v = random::direction(trivial);
+        sim_stats_.thawed = static_cast<int>(thawed_.size());
+    }
+
+    //--------------------------------------------------------------------------
+    //! How long until @p ent gets to act again; also moves it between tiers.
+    //! Frozen entities are taken out of the schedule entirely (0).
+    //--------------------------------------------------------------------------
+    scheduler::time_t next_delay_(entity& ent) {
+        auto const& cfg = definitions_->get_config();
+
+        auto const tier = tier_at_(ent.position());
+        set_tier_(ent, tier);
+
+        switch (tier) {
+        case sim_tier::full :
+            return scheduler::delay_for(ent.data.speed);
+        case sim_tier::coarse :
+            return scheduler::delay_for(ent.data.speed, cfg.sim_interval);
+        case sim_tier::frozen :
+            break;
         }
 
-        return try_move(ent, v) == move_result::ok;
+        frozen_.push_back(frozen_t {ent.instance_id, scheduler_.now()});
+
+        return 0;
     }
-    
+
     //--------------------------------------------------------------------------
-    void update_entities_(random::generator& trivial) {
-        entities_.with_each_entity([&](entity& ent) {
-            update_entity_(trivial, ent);
-        });
+    //! advance by one turn; only entities that are due get to act.
+    //!
+    //! Entities near the player act at their own speed, those further away act
+    //! only every config::sim_interval turns, and those beyond that are frozen
+    //! and cost nothing until the player comes back into range, at which point
+    //! they are moved as if they had been wandering about all along.
+    //!
+    //! Entities first decide what to do in parallel, each with its own random
+    //! stream derived from @p seed, its id and the time; the results are then
+    //! applied in scheduling order. The outcome is the same for any number of
+    //! threads.
+    //!
+    //! While the player is away this only touches the level itself; entities
+    //! that should respawn are counted and left for apply_respawns.
+    //--------------------------------------------------------------------------
+    void advance(uint32_t const seed, thread_pool& pool) {
+        auto constexpr min_chunk       = 64;
+        auto constexpr respawn_percent = 10;
+        auto constexpr respawn_turns   = 50;
+
+        auto const& cfg = definitions_->get_config();
+
+        sim_stats_.thawed = 0;
+
+        auto const turn = scheduler_.now() / scheduler::turn_length;
+        if (turn % static_cast<scheduler::time_t>(cfg.sim_interval) == 0) {
+            thaw_entities_(seed);
+        }
+
+        if (!player_present_
+         && turn % respawn_turns == 0
+         && entities_.size() + pending_respawns_ < population_
+         && random::percent(random_) < respawn_percent
+        ) {
+            ++pending_respawns_;
+        }
+
+        auto const& ents = entities_;
+
+        auto const acted = scheduler_.advance_parallel(
+            scheduler::turn_length, pool, min_chunk, intents_
+          , [&](entity_id const id, scheduler::time_t const time) {
+                intent_t intent;
+
+                ents.with_entity(id, [&](entity const& ent) {
+                    auto gen = random::philox4x32 {seed}.derive(time).derive(id_to_value(id));
+                    intent = decide_entity_(gen, ent);
+                });
+
+                return intent;
+            }
+          , [&](entity_id const id, intent_t const& intent) {
+                auto delay = scheduler::time_t {0};
+
+                entities_.with_entity(id, [&](entity& ent) {
+                    resolve_entity_(ent, intent);
+                    delay = next_delay_(ent);
+                });
+
+                return delay;
+            }
+        );
+
+        sim_stats_.acted = static_cast<int>(acted);
     }
 
     //--------------------------------------------------------------------------
-    //! advance by one turn
+    //! Spawn the entities that advance decided should respawn; this touches
+    //! the item store and so must be done on the main thread.
     //--------------------------------------------------------------------------
-    void advance(random::generator& trivial) {
-        update_entities_(trivial);
+    void apply_respawns() {
+        for (; pending_respawns_ > 0; --pending_respawns_) {
+            auto const& room = rooms_[
+                random::uniform_range(random_, size_t {0}, rooms_.size() - 1)
+            ];
+
+            spawn_entity_(random_, spawn_table_for_(room), room.bounds());
+        }
     }
 
     //--------------------------------------------------------------------------
@@ -576,8 +830,12 @@ public:
     //!         message_type::get_which_prompt  - more than one item
     //!         message_type::get_ok            - ok; just one item
     //--------------------------------------------------------------------------
-    message_type can_get_item(ipoint2 const p) const {    
-        switch (items_.count_items_at(p)) {
+    message_type can_get_item(ipoint2 const p) const {
+        if (!grid_.is_valid(p)) {
+            return message_type::get_no_items;
+        }
+
+        switch (item_stacks_.count_at(p)) {
         case 0  : return message_type::get_no_items;
         case 1  : return message_type::get_ok;
         default : return message_type::get_which_prompt;
@@ -586,6 +844,9 @@ public:
 
     //--------------------------------------------------------------------------
     //! Get the item at @p index in the item stack at @p p, and remove it from the level.
+    //! Items taken from the level leave its arena for the global one, and so
+    //! get a new id.
+    //! @returns the item's new id.
     //--------------------------------------------------------------------------
     item_id take_item_at(ipoint2 const p) {
         item_id result {};
@@ -596,33 +857,79 @@ public:
 
         BK_ASSERT(n == 1);
 
-        return result;
+        update_item_stack_(p);
+
+        return item_store_->move_to(result, item_arena {});
     }
 
     item_id take_item_at(ipoint2 const p, item_id const iid) {
         auto const result = items_.remove_item_at(p, iid);
         BK_ASSERT(result == true);
 
-        return iid;
+        update_item_stack_(p);
+
+        return item_store_->move_to(iid, item_arena {});
     }
 
-    item_collection const& list_items_at(ipoint2 const p) const {
-        static item_collection result; //TODO
+    //--------------------------------------------------------------------------
+    //! Move all the items at @p p into @p items at once; as with take_item_at
+    //! they move to the global arena.
+    //! @returns the number of items moved.
+    //--------------------------------------------------------------------------
+    int take_all_items_at(ipoint2 const p, item_collection& items) {
+        auto& istore = *item_store_;
 
-        result.clear();
-        items_.for_each_item_at(p, [&](item_id const itm) {
-            result.insert(itm);
+        taken_.clear();
+        auto const n = items_.remove_items_at_and(p, [&](item_id const itm) {
+            taken_.push_back(istore.move_to(itm, item_arena {}));
         });
 
-        return result;
+        if (n) {
+            items.insert_all(taken_, istore, definitions_->get_items());
+            update_item_stack_(p);
+        }
+
+        return n;
+    }
+
+    //--------------------------------------------------------------------------
+    //! The items at @p p; invalidated by any change to the items on the level.
+    //--------------------------------------------------------------------------
+    item_id_view list_items_at(ipoint2 const p) const {
+        return items_.items_at(p);
     }
 
+    //--------------------------------------------------------------------------
+    //! Put @p id on the floor at @p p; it moves into the level's arena and so
+    //! gets a new id.
     //--------------------------------------------------------------------------
     message_type drop_item_at(ipoint2 const p, item_id const id) {
-        items_.insert_at(p, id);
+        items_.insert_at(p, item_store_->move_to(id, item_arena_.get()));
+        update_item_stack_(p);
+
         return message_type::none;
     }
 
+    //--------------------------------------------------------------------------
+    //! Move all of @p items to @p p at once, leaving @p items empty.
+    //--------------------------------------------------------------------------
+    void drop_items_at(ipoint2 const p, item_collection& items) {
+        if (items.empty()) {
+            return;
+        }
+
+        auto&      istore = *item_store_;
+        auto const arena  = item_arena_.get();
+
+        items_.insert_batch([&](auto&& insert) {
+            items.remove_all_and([&](item_id const itm) {
+                insert(p, istore.move_to(itm, arena));
+            });
+        });
+
+        update_item_stack_(p);
+    }
+
     //--------------------------------------------------------------------------
     using adjacency = boost::container::static_vector<ipoint2, 9>;
 
@@ -677,15 +984,24 @@ public:
     void kill_entity(entity& ent) {
         auto const p = ent.position();
 
-        items_.insert_at(p, ent.items());
+        drop_items_at(p, ent.items());
 
+        if (ent.data.tier == sim_tier::frozen) {
+            auto const id = ent.instance_id;
+            frozen_.erase(std::remove_if(std::begin(frozen_), std::end(frozen_)
+              , [id](frozen_t const& f) { return f.id == id; }), std::end(frozen_));
+        }
+
+        --tier_count_(ent.data.tier);
+
+        scheduler_.remove(ent.instance_id);
         entities_.remove(p, ent.instance_id);
     }
 
     //--------------------------------------------------------------------------
     optional<entity const&> entity_at(ipoint2 const p) const {
         entity const& ent = *player_;
-        if (ent.position() == p) {
+        if (player_present_ && ent.position() == p) {
             return {ent};
         }
 
@@ -795,11 +1111,10 @@ public:
 
         auto const& items = definitions_->get_items();
         items_.for_each_item_at(p, [&](item_id const itm) {
-            auto const& id   = (*item_store_)[itm].id;
-            auto const& name = items.get_locale(id).name;
+            auto const& name = (*item_store_)[itm].name(items);
 
             result.push_back('\n');
-            result.append(name);
+            result.append(name.data(), name.size());
         });
         
         entities_.with_entity_at(p, [&](entity const& ent) {
@@ -816,6 +1131,11 @@ public:
         return result;
     }
 private:
+    //--------------------------------------------------------------------------
+    void update_item_stack_(ipoint2 const p) {
+        item_stacks_.update(p, items_, *item_store_, definitions_->get_items());
+    }
+
     //--------------------------------------------------------------------------
     message_type use_stair_(ipoint2 const p, bool const down) const {
         auto const type = grid_.get(attribute::tile_type, p);
@@ -1091,13 +1411,6 @@ private:
     //--------------------------------------------------------------------------
     void place_entities_(random::generator& substantive) {
         auto constexpr generate_chance = 20;
-        
-        spawn_table stable {};
-
-        auto const& items       = definitions_->get_items();
-        auto const& entities    = definitions_->get_entities();
-        auto const& loot_tables = definitions_->get_loot_tables();
-        auto&       istore      = *item_store_;
 
         for (auto const& room : rooms_) {
             auto const count = [&] {
@@ -1112,24 +1425,68 @@ private:
                 return 6;
             }();
                       
-            auto const bounds = room.bounds();
+            auto const  bounds = room.bounds();
+            auto const& table  = spawn_table_for_(room);
 
             for (int i = 0; i < count; ++i) {
-                auto ent = generate_entity(substantive, entities, items, loot_tables, istore, stable);
-                
-                auto const p = generate_entity_placement(substantive, bounds, ent);
-                if (!p) {
+                if (!spawn_entity_(substantive, table, bounds)) {
                     break;
                 }
-
-                auto const result = entities_.insert_at(*p, std::move(ent));
-                if (!result) {
-                    BK_TODO_FAIL();
-                }
             }
         }
     }
 
+    //--------------------------------------------------------------------------
+    //! The table deciding what spawns in a room; there is only one type of
+    //! room for now.
+    //--------------------------------------------------------------------------
+    spawn_table const& spawn_table_for_(room const&) const {
+        static auto const room_basic = spawn_table_def_id {slash_hash32("ROOM_BASIC")};
+        return definitions_->get_spawn_tables()[room_basic];
+    }
+
+    //--------------------------------------------------------------------------
+    //! Generate an entity from @p table somewhere within @p bounds and
+    //! schedule it.
+    //! @returns false if nothing spawns at this depth, or there was no room.
+    //--------------------------------------------------------------------------
+    bool spawn_entity_(
+        random::generator& gen
+      , spawn_table const& table
+      , irect const        bounds
+    ) {
+        auto const def = table(gen, depth_);
+        if (!def) {
+            return false;
+        }
+
+        auto const& items       = definitions_->get_items();
+        auto const& entities    = definitions_->get_entities();
+        auto const& loot_tables = definitions_->get_loot_tables();
+        auto&       istore      = *item_store_;
+
+        auto ent = generate_entity(
+            gen, entities, items, loot_tables, istore, *def, drops_, item_arena_.get());
+
+        auto const p = generate_entity_placement(gen, bounds, ent);
+        if (!p) {
+            return false;
+        }
+
+        auto const id    = ent.instance_id;
+        auto const delay = scheduler::delay_for(ent.data.speed);
+
+        auto const result = entities_.insert_at(*p, std::move(ent));
+        if (!result) {
+            BK_TODO_FAIL();
+        }
+
+        scheduler_.insert(id, delay);
+        ++tier_count_(sim_tier::full);
+
+        return true;
+    }
+
     //--------------------------------------------------------------------------
     void generate_(
         random::generator& substantive
@@ -1291,9 +1648,15 @@ private:
 
     item_store* item_store_     = nullptr;
 
+    //! every item on the level, or carried by its entities; freed along with
+    //! the level.
+    unique_item_arena item_arena_;
+
     tile_sheet_set* tiles_sheets_ = nullptr;
 
     player*           player_;
+    random::generator random_;
+    int               depth_;
 
     grid_storage      grid_;
     bsp_layout        layout_;
@@ -1302,8 +1665,28 @@ private:
     ipoint2 stairs_up_   = ipoint2 {0, 0};
     ipoint2 stairs_down_ = ipoint2 {0, 0};
 
-    item_map   items_;
-    entity_map entities_;
+    item_map           items_;
+    item_stack_summary item_stacks_;
+    entity_map         entities_;
+    scheduler          scheduler_;
+
+    //! an entity taken out of the schedule, and since when.
+    struct frozen_t {
+        entity_id         id;
+        scheduler::time_t since;
+    };
+
+    std::vector<frozen_t> frozen_;
+    std::vector<frozen_t> thawed_;  //!< scratch space for thaw_entities_
+    std::vector<item_id>  taken_;   //!< scratch space for take_all_items_at
+    std::vector<intent_t> intents_; //!< scratch space for advance
+    loot_batch            drops_;   //!< scratch space for spawn_entity_
+
+    sim_stats_t sim_stats_;
+
+    size_t population_       = 0; //!< entities to keep the level topped up to
+    size_t pending_respawns_ = 0;
+    bool   player_present_   = true;
 };
 
 //==============================================================================
@@ -1597,14 +1980,21 @@ public:
     using completion_handler = std::function<void (optional<item_id> iid)>;
 
     //--------------------------------------------------------------------------
+    //! @param grouped whether identical items share a row; only for lists that
+    //!        are just looked at, as a row gives a single item back.
     input_mode_base* enter_mode(
         gui::item_list&    list
-      , item_collection const&   items
+      , item_id_view const items
       , string_ref const   title
       , completion_handler handler
+      , bool const         grouped = false
     ) {
         list.clear();
-        list.insert(items);
+        if (grouped) {
+            list.insert_grouped(items);
+        } else {
+            list.insert(items);
+        }
         list.set_title(title);
 
         list_    = &list;
@@ -1757,9 +2147,10 @@ public:
     template <typename Handler>
     void enter_selection_mode(
         gui::item_list&   list
-      , item_collection const&  items
+      , item_id_view const items
       , string_ref const  title
       , Handler&&         handler
+      , bool const        grouped = false
     ) {
         BK_ASSERT(cur_mode == nullptr);
 
@@ -1768,6 +2159,7 @@ public:
           , items
           , title
           , std::forward<Handler>(handler)
+          , grouped
         );
     }
 
@@ -1919,27 +2311,15 @@ public:
     void next_level(int level) {
         BK_ASSERT_SAFE(level >= 0);
 
-        auto const size = static_cast<int>(levels_.size());
-
-        if (level == size) {
-            levels_.emplace_back(
-                random_substantive_
-              , random_trivial_
-              , *definitions_
-              , item_store_
-              , player_
-              , tile_sheets_
-              , level_w
-              , level_h
-            );
+        sync_background_();
 
-            cur_level_ = &levels_.back();
-        } else if (level < size) {
-            cur_level_ = &levels_[level];
-        } else {
-            BK_TODO_FAIL();
+        if (cur_level_) {
+            cur_level_->set_player_present(false);
         }
-        
+
+        cur_level_ = &require_level_(level);
+        cur_level_->set_player_present(true);
+
         level_number_ = level;
         do_zoom_reset();
     }
@@ -1951,7 +2331,11 @@ public:
 
         BK_ASSERT_SAFE(level < static_cast<int>(levels_.size()));
 
-        cur_level_ = &levels_[level];
+        sync_background_();
+
+        cur_level_->set_player_present(false);
+        cur_level_ = &require_level_(level);
+        cur_level_->set_player_present(true);
 
         level_number_ = level;
         player_.move_to(cur_level_->down_stair());
@@ -1991,7 +2375,92 @@ public:
 
     void advance() {
         turn_++;
-        cur_level_->advance(random_trivial_);
+        cur_level_->advance(random_trivial_.get_seed(), thread_pool_);
+
+        ++background_turns_;
+        advance_background_(false);
+    }
+
+    //--------------------------------------------------------------------------
+    //! Pass the turns that have gone by on to the levels the player isn't on.
+    //! They are advanced on the background worker, a batch of turns at a time,
+    //! and only once it has finished with the previous batch unless @p force.
+    //--------------------------------------------------------------------------
+    void advance_background_(bool const force) {
+        auto constexpr batch_turns = 20;
+
+        if (background_turns_ == 0) {
+            return;
+        }
+
+        if (!force && (background_turns_ < batch_turns || !background_.is_idle())) {
+            return;
+        }
+
+        std::vector<level*> lvls;
+        for (auto const& lvl : levels_) {
+            if (lvl.get() != cur_level_) {
+                lvls.push_back(lvl.get());
+            }
+        }
+
+        auto const turns = background_turns_;
+        auto const seed  = random_trivial_.get_seed();
+
+        background_turns_ = 0;
+
+        if (lvls.empty()) {
+            return;
+        }
+
+        background_.post([this, lvls = std::move(lvls), turns, seed] {
+            for (auto const lvl : lvls) {
+                for (auto i = 0; i < turns; ++i) {
+                    lvl->advance(seed, background_pool_);
+                }
+            }
+        });
+    }
+
+    //--------------------------------------------------------------------------
+    //! Bring every level up to date and hand the background levels' deferred
+    //! work to the main thread; required before touching any level other than
+    //! the current one.
+    //--------------------------------------------------------------------------
+    void sync_background_() {
+        advance_background_(true);
+        background_.sync();
+
+        for (auto const& lvl : levels_) {
+            lvl->apply_respawns();
+        }
+    }
+
+    //--------------------------------------------------------------------------
+    //! The level at @p depth; generated the first time it is visited. Levels
+    //! are kept, along with their item arenas, for as long as the game lasts.
+    //--------------------------------------------------------------------------
+    level& require_level_(int const depth) {
+        BK_ASSERT_SAFE(depth >= 0 && depth <= static_cast<int>(levels_.size()));
+
+        auto const i = static_cast<size_t>(depth);
+
+        if (i == levels_.size()) {
+            levels_.push_back(std::make_unique<level>(
+                random_substantive_
+              , random_trivial_
+              , random::derive_seed(config_->substantive_seed, static_cast<uint64_t>(depth))
+              , depth
+              , *definitions_
+              , item_store_
+              , player_
+              , tile_sheets_
+              , level_w
+              , level_h
+            ));
+        }
+
+        return *levels_[i];
     }
 
     void set_door_state(bool const opened) {
@@ -2106,7 +2575,7 @@ public:
         auto const& istore = item_store_;
 
         player_.equip().unequip(iid, idefs, istore);
-        player_.items().insert(iid);
+        player_.items().insert(iid, istore, idefs);
 
         auto const& name = istore[iid].name(idefs);
 
@@ -2163,10 +2632,10 @@ public:
         auto const& istore = item_store_;
         auto const& idefs  = definitions_->get_items();
 
-        player_.items().remove(iid);
-        cur_level_->drop_item_at(p, iid);
-
         print_message(message_type::drop_ok, get_localized_name(iid));
+
+        player_.items().remove(iid, istore, idefs);
+        cur_level_->drop_item_at(p, iid);
     }
 
     //--------------------------------------------------------------------------
@@ -2175,11 +2644,10 @@ public:
 
         auto&       lvl    = *cur_level_;
         auto&       gen    = random_trivial_;
-        auto const& istore = item_store_;
         auto const& edefs  = definitions_->get_entities();
         auto const& msgs   = definitions_->get_messages();
 
-        auto const att = attacker.get_attack_value(gen, istore);
+        auto const att = attacker.get_attack_value(gen);
         auto const def = defender.get_defence_value(gen, edefs, att.type);
         auto const dmg = static_cast<health_t>(std::max(0, att.value - def.value));
 
@@ -2366,7 +2834,7 @@ public:
 
     //--------------------------------------------------------------------------
     void get_item_(item_id const itm) {
-        player_.items().insert(itm);
+        player_.items().insert(itm, item_store_, definitions_->get_items());
         print_message(message_type::get_ok, get_localized_name(itm));
         advance();
     }
@@ -2381,12 +2849,7 @@ public:
           , [=](optional<item_id> maybe_sel) {
                 if (!maybe_sel) { return; }
 
-                auto const itm = *maybe_sel;
-                auto const ok  = (cur_level_->take_item_at(p, itm) == itm);
-
-                BK_ASSERT_DBG(ok == true);
-
-                function(itm);
+                function(cur_level_->take_item_at(p, *maybe_sel));
             }
         );
     }
@@ -2410,6 +2873,20 @@ public:
         }
     }
 
+    //--------------------------------------------------------------------------
+    void do_get_all() {
+        auto const p = player_.position();
+        auto const n = cur_level_->take_all_items_at(p, player_.items());
+
+        if (n == 0) {
+            print_message(message_type::get_no_items);
+            return;
+        }
+
+        print_message(message_type::get_all_ok, n);
+        advance();
+    }
+
     //--------------------------------------------------------------------------
     void do_inventory() {
         auto const title = get_message_string_(message_type::title_inventory);
@@ -2421,8 +2898,11 @@ public:
             return;
         }
 
+        print_message(message_type::inventory_weight, player_.carried_weight());
+
+        //nothing is chosen here, so identical items can share a row.
         input_state_.enter_selection_mode(list, items, title, [this](optional<item_id> maybe_sel) {
-        });
+        }, true);
     }
 
     //--------------------------------------------------------------------------
@@ -2478,6 +2958,14 @@ public:
         });
     }
 
+    //--------------------------------------------------------------------------
+    void do_debug_stats() {
+        auto const& stats = cur_level_->sim_stats();
+
+        print_message(message_type::debug_sim_stats
+          , stats.full, stats.coarse, stats.frozen, stats.acted, stats.thawed);
+    }
+
     ////////////////////////////////////////////////////////////////////////////
     // Sinks
     ////////////////////////////////////////////////////////////////////////////
@@ -2499,12 +2987,14 @@ public:
 
         switch (cmd) {
         case ct::equipment  : do_equipment();         break;
+        case ct::debug_stats : do_debug_stats();      break;
         case ct::take_off   : do_take_off();          break;
         case ct::wield_wear : do_wield_wear();        break;
         case ct::inventory  : do_inventory();         break;
         case ct::open       : do_open();              break;
         case ct::close      : do_close();             break;
         case ct::get        : do_get();               break;
+        case ct::get_all    : do_get_all();           break;
         case ct::drop       : do_drop();              break;
         case ct::scroll_n   : do_scroll( 0,  1, 0);   break;
         case ct::scroll_s   : do_scroll( 0, -1, 0);   break;
@@ -2585,6 +3075,8 @@ private:
     random::generator random_substantive_;
     random::generator random_trivial_;
 
+    thread_pool thread_pool_;
+
     application app_;
     renderer    renderer_;
     
@@ -2601,10 +3093,19 @@ private:
 
     view   view_;
 
-    std::vector<level> levels_;
+    //! indexed by depth; held by pointer so that a level stays put as more
+    //! are added.
+    std::vector<std::unique_ptr<level>> levels_;
+
     level* cur_level_    = nullptr;
     int    level_number_ = 0;
 
+    //! advances the levels the player isn't on; declared after levels_ (and
+    //! the pool it uses) so that it finishes before they are destroyed.
+    thread_pool       background_pool_ {1};
+    background_worker background_;
+    int               background_turns_ = 0;
+
     uint64_t turn_ = 0;
 
     player player_;
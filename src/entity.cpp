@@ -1,6 +1,7 @@
 #include "entity.hpp"
 #include "json.hpp"
 #include "loot_table.hpp"
+#include "definition_table.hpp"
 
 #include <boost/container/flat_map.hpp>
 
@@ -21,6 +22,7 @@ struct bkrl::entity_definition {
     tex_point_i   tile_position = tex_point_i {0, 0};
     argb8         tile_color    = argb8 {255, 255, 255, 255};
     dist_t        health;  //!< health
+    speed_t       speed = scheduler::speed_normal; //!< relative speed
 };
 
 bkrl::path_string bkrl::entity_definition::tile_filename {};
@@ -49,6 +51,13 @@ public:
     void load_definitions(cref data) {
         rule_ent_root(data);
     }
+
+    ////////////////////////////////////////////////////////////////////////////
+    void link(loot_table_definitions const& loot_defs) {
+        for (auto& def : definitions_) {
+            def.drops.link(loot_defs);
+        }
+    }
     
     //--------------------------------------------------------------------------
     void rule_ent_root(cref value) {
@@ -83,11 +92,13 @@ public:
         auto const& defs  = json::require_array(value[jc::field_definitions]);
         auto const& array = defs.array_items();
 
-        definitions_.reserve(array.size());
+        definitions_.reserve(definitions_.size() + array.size());
 
         for (auto&& def : array) {
             rule_ent_definition(def);
         }
+
+        update_locale_table_();
     }
 
     //--------------------------------------------------------------------------
@@ -97,8 +108,12 @@ public:
         rule_ent_color(value);
         rule_ent_tile(value);
         rule_ent_health(value);
+        rule_ent_speed(value);
 
-        definitions_.emplace(cur_def_.id, std::move(cur_def_));
+        auto const id = cur_def_.id;
+        if (!definitions_.insert(id, std::move(cur_def_))) {
+            BK_TODO_FAIL(); //duplicate definition
+        }
     }
 
     void rule_end_id(cref value) {
@@ -151,6 +166,19 @@ public:
         cur_def_.health = jc::get_random(value[jc::field_health]);
     }
 
+    //--------------------------------------------------------------------------
+    void rule_ent_speed(cref value) {
+        auto const speed = json::default_int<speed_t>(
+            value[jc::field_speed], scheduler::speed_normal
+        );
+
+        if (speed < scheduler::speed_min) {
+            BK_TODO_FAIL();
+        }
+
+        cur_def_.speed = speed;
+    }
+
     ////////////////////////////////////////////////////////////////////////////
     void load_locale(cref data) {
         rule_loc_root(data);
@@ -180,6 +208,8 @@ public:
         }
 
         locales_.emplace(cur_lang_, std::move(cur_loc_map_));
+
+        update_locale_table_();
     }
 
     //--------------------------------------------------------------------------
@@ -194,22 +224,40 @@ public:
     }
 
     ////////////////////////////////////////////////////////////////////////////
-    definition const& get_definition(entity_def_id const id) const {
-        auto const it = definitions_.find(id);
-        if (it == std::end(definitions_)) {
+    entity_def_index index_of(entity_def_id const id) const {
+        auto const index = definitions_.find(id);
+        if (!index) {
             BK_TODO_FAIL();
         }
 
-        return it->second;
+        return *index;
     }
-    
+
+    definition const& get_definition(entity_def_index const index) const {
+        return definitions_[index];
+    }
+
+    definition const& get_definition(entity_def_id const id) const {
+        return get_definition(index_of(id));
+    }
+
+    //--------------------------------------------------------------------------
+    locale const& get_locale(entity_def_index const index) const {
+        auto const i = id_to_value(index);
+        if (i >= current_locale_.size()) {
+            return undefined_locale;
+        }
+
+        return *current_locale_[i];
+    }
+
     locale const& get_locale(entity_def_id const id) const {
-        auto const it = current_locale_->find(id);
-        if (it == std::end(*current_locale_)) {
+        auto const index = definitions_.find(id);
+        if (!index) {
             return undefined_locale;
         }
 
-        return it->second;
+        return get_locale(*index);
     }
 
     void set_locale(lang_id const lang) {
@@ -218,19 +266,17 @@ public:
             BK_TODO_FAIL();
         }
 
-        current_locale_ = &it->second;
+        current_lang_ = lang;
+        update_locale_table_();
     }
 
     auto get_definitions_size() const {
-        return static_cast<int>(definitions_.size());
+        return definitions_.size();
     }
     
     auto const& get_definition_at(int const index) const {
-        BK_ASSERT(index < get_definitions_size());
-
-        auto it = definitions_.begin();
-        std::advance(it, index);
-        return it->second;
+        BK_ASSERT(index >= 0 && index < get_definitions_size());
+        return definitions_[entity_def_index {static_cast<uint16_t>(index)}];
     }
 private:
     template <typename K, typename V>
@@ -238,6 +284,27 @@ private:
 
     using locale_map = map_t<entity_def_id, locale>;
 
+    //--------------------------------------------------------------------------
+    //! Line the strings for the current language up with definitions_.
+    //--------------------------------------------------------------------------
+    void update_locale_table_() {
+        if (!current_lang_) {
+            return;
+        }
+
+        auto const& loc_map = locales_.find(*current_lang_)->second;
+
+        current_locale_.clear();
+        current_locale_.reserve(definitions_.size());
+
+        for (auto const& def : definitions_) {
+            auto const it = loc_map.find(def.id);
+            current_locale_.push_back(
+                (it != std::end(loc_map)) ? &it->second : &undefined_locale
+            );
+        }
+    }
+
     loot_table_parser loot_parser_;
 
     definition cur_def_;
@@ -245,10 +312,11 @@ private:
     lang_id    cur_lang_;
     locale_map cur_loc_map_;
 
-    map_t<entity_def_id, definition> definitions_;
-    map_t<lang_id,       locale_map> locales_;
+    definition_table<entity_def_id, entity_def_index, definition> definitions_;
+    map_t<lang_id, locale_map> locales_;
 
-    locale_map const* current_locale_ = nullptr;
+    optional<lang_id>          current_lang_;
+    std::vector<locale const*> current_locale_; //!< indexed by entity_def_index
 };
 
 bkrl::utf8string const bkrl::detail::entity_definitions_impl::undefined_name {"{undefined name}"};
@@ -266,7 +334,7 @@ bkrl::tex_point_i bkrl::detail::entity_definitions_impl::player_tile {0, 0};
 ////////////////////////////////////////////////////////////////////////////////
 bkrl::entity_render_info_t
 bkrl::entity::render_info(entity_definitions const& defs) const {
-    auto const& def = defs.get_definition(id);
+    auto const& def = defs.get_definition(def_index);
     
     return entity_render_info_t {
         def.tile_position
@@ -275,11 +343,11 @@ bkrl::entity::render_info(entity_definitions const& defs) const {
 }
 
 bkrl::string_ref bkrl::entity::name(defs_t defs) const {
-    return defs.get_locale(id).name;
+    return defs.get_locale(def_index).name;
 }
 
 bkrl::string_ref bkrl::entity::description(defs_t defs) const {
-    return defs.get_locale(id).text;
+    return defs.get_locale(def_index).text;
 }
 
 bool bkrl::entity::apply_damage(health_t const delta) {
@@ -326,11 +394,34 @@ void bkrl::entity_definitions::load_definitions(json::cref data) {
     impl_->load_definitions(data);
 }
 
+//------------------------------------------------------------------------------
+void bkrl::entity_definitions::link(loot_table_definitions const& loot_defs) {
+    impl_->link(loot_defs);
+}
+
 //------------------------------------------------------------------------------
 void bkrl::entity_definitions::load_locale(json::cref data) {
     impl_->load_locale(data);
 }
 
+//------------------------------------------------------------------------------
+bkrl::entity_def_index
+bkrl::entity_definitions::index_of(entity_def_id const id) const {
+    return impl_->index_of(id);
+}
+
+//------------------------------------------------------------------------------
+bkrl::entity_definition const&
+bkrl::entity_definitions::get_definition(entity_def_index const index) const {
+    return impl_->get_definition(index);
+}
+
+//------------------------------------------------------------------------------
+bkrl::entity_locale const&
+bkrl::entity_definitions::get_locale(entity_def_index const index) const {
+    return impl_->get_locale(index);
+}
+
 //------------------------------------------------------------------------------
 bkrl::entity_definition const&
 bkrl::entity_definitions::get_definition(entity_def_id const id) const {
@@ -369,15 +460,14 @@ bkrl::generate_entity(
   , item_definitions       const& item_defs
   , loot_table_definitions const& loot_defs
   , item_store&                   items
-  , spawn_table            const& table
+  , entity_def_index       const  index
+  , loot_batch&                   drops
+  , item_arena             const  arena
 ) {
     //TODO not thread safe; can't be initialized (save / load)
     static auto next_instance_id = uint32_t {0x80000000};
 
-    auto const size  = entity_defs.get_definitions_size();
-    auto const index = random::uniform_range(gen, 0, size - 1);
-
-    auto const& def = entity_defs.get_definition_at(index);
+    auto const& def = entity_defs.get_definition(index);
     auto const& id  = def.id;
 
     entity result;
@@ -385,19 +475,28 @@ bkrl::generate_entity(
     auto const max_health = static_cast<health_t>(def.health(gen));
 
     result.id = id;
+    result.def_index = index;
     result.instance_id = entity_id {next_instance_id++};
     result.data.health = ranged_value<health_t> {max_health};
     result.data.position = {0, 0};
+    result.data.speed = def.speed;
 
     item_birthplace origin;
     origin.type = item_birthplace::entity;
     origin.id   = id_to_value(id);
 
-    def.drops.generate(gen, loot_defs, [&](item_def_id const itm_id, uint16_t const n) {
-        result.data.items.insert(
-            generate_item(gen, itm_id, items, item_defs, origin)
+    drops.clear();
+    def.drops.generate_n(gen, loot_defs, 1, drops);
+
+    auto& inventory = result.data.items;
+    inventory.reserve(drops.result_count());
+
+    for (auto const& drop : drops) {
+        inventory.insert(
+            generate_item(gen, drop.id, items, item_defs, origin, arena)
+          , items, item_defs
         );
-    });
+    }
    
     return result;
 }
@@ -433,7 +532,7 @@ bkrl::player::equip_item(item_id iid, defs_t defs, items_t istore) {
         return try_equip;
     }
 
-    auto const result = items().remove(iid);
+    auto const result = items().remove(iid, istore, defs);
     BK_ASSERT(result == true);
 
     return try_equip;
@@ -450,35 +549,20 @@ bkrl::player::equip() const {
 }
 
 bkrl::damage_t
-bkrl::player::get_attack_value(random_t& gen, items_t items) {
-    auto const opt_weapon = [&]() -> optional<bkrl::item_id> {
-        if (auto const main = equip_.in_slot(equip_slot::hand_main)) {
-            return main;
-        } else if (auto const off = equip_.in_slot(equip_slot::hand_off)) {
-            return off;
-        }
-
-        return { };
-    }();
+bkrl::player::get_attack_value(random_t& gen) {
+    auto const& stats = equip_.stats();
 
-    //TODO unarmed
-    if (!opt_weapon) {
-        return damage_t {1, damage_type::blunt};
-    }
-
-    auto const weapon_id = *opt_weapon;
+    auto const dmg = random::uniform_range(gen, stats.dmg_min, stats.dmg_max);
 
-    auto const& itm = items[weapon_id];
-    auto const  dmg_min = itm.data.weapon.dmg_min; //TODO
-    auto const  dmg_max = itm.data.weapon.dmg_max; //TODO
-    auto const  dmg_type = itm.data.weapon.dmg_type; //TODO
-
-    auto const dmg = random::uniform_range(gen, dmg_min, dmg_max);
+    return damage_t {dmg, stats.dmg_type};
+}
 
-    return damage_t {dmg, dmg_type};
+bkrl::weight_total_t
+bkrl::player::carried_weight() const noexcept {
+    return items().totals().weight + equip_.stats().totals.weight;
 }
 
 bkrl::defence_t
 bkrl::player::get_defence_value(random_t& gen, defs_t defs, damage_type type) {
-    return defence_t {1, type}; // TODO
+    return defence_t {equip_.stats().armor_against(type), type};
 }
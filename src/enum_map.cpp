@@ -307,11 +307,13 @@ bkrl::from_hash(hash_t const hash) {
       , {"open",       ct::open}
       , {"close",      ct::close}
       , {"get",        ct::get}
+      , {"get_all",    ct::get_all}
       , {"drop",       ct::drop}
       , {"inventory",  ct::inventory}
       , {"wield_wear", ct::wield_wear}
       , {"take_off",   ct::take_off}
       , {"equipment",  ct::equipment}
+      , {"debug_stats", ct::debug_stats}
     };
 
     return find_mapping(mappings, hash, ct::invalid);
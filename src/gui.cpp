@@ -595,7 +595,7 @@ public:
         insert_item_(id, istore, idefs, msgs);
     }
 
-    void insert_item(item_collection const& items) {
+    void insert_item(item_id_view const items, bool const grouped) {
         clear();
 
         auto const& istore = *item_store_;
@@ -607,16 +607,30 @@ public:
         list_.add_col("Type");
         list_.add_col("Details");
 
-        items.for_each_item([&](item_id const itm) {
-            insert_item_(itm, istore, idefs, msgs);
-        });
+        if (grouped) {
+            group_items(items, istore, groups_);
+
+            for (auto const& g : groups_) {
+                insert_item_(g.id, istore, idefs, msgs, g.count);
+            }
+        } else {
+            items.for_each_item([&](item_id const itm) {
+                insert_item_(itm, istore, idefs, msgs);
+            });
+        }
 
         list_.layout();
 
         BK_ASSERT(!empty());
     }
 
-    void insert_item_(item_id const id, item_store const& istore, item_definitions const& idefs, message_map const& msgs) {
+    void insert_item_(
+        item_id          const  id
+      , item_store       const& istore
+      , item_definitions const& idefs
+      , message_map      const& msgs
+      , int              const  count = 1
+    ) {
         auto const& itm    = istore[id];
         auto const& name   = itm.name(idefs);
         auto const& type   = to_string(msgs, itm.type);
@@ -628,7 +642,12 @@ public:
 
         auto const row = list_.add_row(name_buffer_);
 
-        list_.set_text(row, col_itm_name,    name);
+        name_buffer_.assign(name.data(), name.size());
+        if (count > 1) {
+            name_buffer_ += " (" + std::to_string(count) + ")";
+        }
+
+        list_.set_text(row, col_itm_name,    name_buffer_);
         list_.set_text(row, col_itm_weight,  weight);
         list_.set_text(row, col_itm_type,    type);
         list_.set_text(row, col_itm_details, info);
@@ -636,7 +655,7 @@ public:
         items_.push_back(id);
     }
 
-    void insert_equip(item_collection const& items) {
+    void insert_equip(item_id_view const items) {
         using msg = message_type;
         using eqs = equip_slot;
 
@@ -751,8 +770,9 @@ private:
 
     char prefix_ = 'a';
 
-    utf8string           name_buffer_;
-    std::vector<item_id> items_;
+    utf8string              name_buffer_;
+    std::vector<item_id>    items_;
+    std::vector<item_group> groups_;
 };
 
 bkrl::gui::item_list::item_list(item_list&&) = default;
@@ -788,8 +808,12 @@ bkrl::item_id bkrl::gui::item_list::at(int const index) {
     return impl_->at(index);
 }
 
-void bkrl::gui::item_list::insert(item_collection const& items) {
-    impl_->insert_item(items);
+void bkrl::gui::item_list::insert(item_id_view const items) {
+    impl_->insert_item(items, false);
+}
+
+void bkrl::gui::item_list::insert_grouped(item_id_view const items) {
+    impl_->insert_item(items, true);
 }
 
 void bkrl::gui::item_list::insert(item_id const id) {
@@ -827,7 +851,7 @@ bool bkrl::gui::item_list::empty() const noexcept {
 ////////////////////////////////////////////////////////////////////////////////
 // gui::equip_list
 ////////////////////////////////////////////////////////////////////////////////
-void bkrl::gui::equip_list::insert(item_collection const& items) {
+void bkrl::gui::equip_list::insert(item_id_view const items) {
     impl_->insert_equip(items);
 }
 
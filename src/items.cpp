@@ -1,9 +1,8 @@
 #include "items.hpp"
 
-#include <unordered_map>
-
 #include "assert.hpp"
 #include "algorithm.hpp"
+#include "definition_table.hpp"
 #include "json.hpp"
 #include "loot_table.hpp"
 
@@ -11,18 +10,6 @@
 
 namespace jc = bkrl::json::common;
 
-////////////////////////////////////////////////////////////////////////////////
-namespace std {
-////////////////////////////////////////////////////////////////////////////////
-    template <> struct hash<bkrl::item_id> {
-        inline size_t operator()(bkrl::item_id const x) const noexcept {
-            return hash<bkrl::item_id::value_type>{}(bkrl::id_to_value(x));
-        }
-    };
-////////////////////////////////////////////////////////////////////////////////
-} //namespace std
-////////////////////////////////////////////////////////////////////////////////
-
 ////////////////////////////////////////////////////////////////////////////////
 namespace {
 ////////////////////////////////////////////////////////////////////////////////
@@ -41,15 +28,6 @@ std::vector<T>& merge(std::vector<T>& lhs, std::vector<T>& rhs) {
     return dst;
 }
 
-template <typename T, typename K>
-static auto& require_at(T& container, K const& key) {
-    auto const it = container.find(key);
-
-    BK_ASSERT(it != std::end(container));
-
-    return it->second;
-}
-
 template <typename T>
 void call_destructor(T& object) noexcept {
     (void)object;
@@ -71,7 +49,7 @@ bkrl::get_definition(
   , item_definitions const& defs
   , item_store       const& store
 ) {
-    return defs.get_definition(store[id].id);
+    return defs.get_definition(store[id].def_index);
 }
 
 bkrl::item_locale const&
@@ -80,7 +58,7 @@ bkrl::get_locale(
   , item_definitions const& defs
   , item_store       const& store
 ) {
-    return defs.get_locale(store[id].id);
+    return defs.get_locale(store[id].def_index);
 }
 
 bkrl::string_ref
@@ -284,15 +262,52 @@ bkrl::tex_point_i bkrl::item_definition::tile_size     {0, 0};
 //    return id;
 //}
 
+////////////////////////////////////////////////////////////////////////////////
+// item_collection
+////////////////////////////////////////////////////////////////////////////////
+
+//------------------------------------------------------------------------------
+void bkrl::item_collection::insert(item_id const itm, store_t store, defs_t defs) {
+    begin_tracked_();
+
+    insert_(itm);
+    add_(itm, store, defs);
+}
+
+//------------------------------------------------------------------------------
+bool bkrl::item_collection::remove(item_id const itm, store_t store, defs_t defs) {
+    begin_tracked_();
+
+    if (!remove_(itm)) {
+        return false;
+    }
+
+    subtract_(itm, store, defs);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+void bkrl::item_collection::add_(item_id const itm, store_t store, defs_t defs) {
+    auto const& i = store[itm];
+    totals_.add(i.type, i.weight(defs));
+}
+
+//------------------------------------------------------------------------------
+void bkrl::item_collection::subtract_(item_id const itm, store_t store, defs_t defs) {
+    auto const& i = store[itm];
+    totals_.subtract(i.type, i.weight(defs));
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // item
 ////////////////////////////////////////////////////////////////////////////////
+static_assert(sizeof(bkrl::item) <= 16, "keep items small; see item_data_t");
+
 //------------------------------------------------------------------------------
 bkrl::item::item(item&& other)
-    : id     {std::move(other.id)}
-    , origin {std::move(other.origin)}
-  //, data   {must init the union}
-    , type   {std::move(other.type)}
+    : def_index {std::move(other.def_index)}
+  //, data      {must init the union}
+    , type      {std::move(other.type)}
 {
     auto& dst = data;
     auto& src = other.data;
@@ -302,13 +317,24 @@ bkrl::item::item(item&& other)
     switch (type) {
     default            : BK_TODO_FAIL();
     case it::none      : break;
-    case it::container : placement_move(dst.stack,  src.stack);  break;
+    case it::container : break; //contents are kept by item_store::contents
     case it::weapon    : placement_move(dst.weapon, src.weapon); break;
     case it::armor     : placement_move(dst.armor,  src.armor);  break;
     case it::potion    : placement_move(dst.potion, src.potion); break;
     }
 }
 
+//------------------------------------------------------------------------------
+bkrl::item& bkrl::item::operator=(item&& other) {
+    if (this != &other) {
+        //the active member of data depends on type; simplest to start over.
+        this->~item();
+        new (this) item {std::move(other)};
+    }
+
+    return *this;
+}
+
 //------------------------------------------------------------------------------
 bkrl::item::~item() {
     using it = item_type;
@@ -316,7 +342,7 @@ bkrl::item::~item() {
     switch (type) {
     default            : BK_TODO_FAIL();
     case it::none      : break;
-    case it::container : call_destructor(data.stack);  break;
+    case it::container : break;
     case it::weapon    : call_destructor(data.weapon); break;
     case it::armor     : call_destructor(data.armor);  break;
     case it::potion    : call_destructor(data.potion); break;
@@ -326,7 +352,7 @@ bkrl::item::~item() {
 //------------------------------------------------------------------------------
 bkrl::string_ref
 bkrl::item::name(defs_t defs) const {
-    return defs.get_locale(id).name;
+    return defs.get_locale(def_index).name;
 }
 
 //------------------------------------------------------------------------------
@@ -344,7 +370,7 @@ bkrl::item::is_equippable(defs_t defs) const {
 //------------------------------------------------------------------------------
 bkrl::equip_slot_flags
 bkrl::item::equip_slots(defs_t defs) const {   
-    return defs.get_definition(id).slots;
+    return defs.get_definition(def_index).slots;
 }
 
 //------------------------------------------------------------------------------
@@ -412,13 +438,13 @@ bkrl::item::short_description(msg_t msgs) const {
 //------------------------------------------------------------------------------
 bkrl::weight_t
 bkrl::item::weight(defs_t defs) const {
-    return defs.get_definition(id).weight;
+    return defs.get_definition(def_index).weight;
 }
 
 //------------------------------------------------------------------------------
 bkrl::item_render_info_t
 bkrl::item::render_info(defs_t defs) const {
-    auto const& idef = defs.get_definition(id);
+    auto const& idef = defs.get_definition(def_index);
     
     return item_render_info_t {
         idef.tile_position
@@ -426,35 +452,474 @@ bkrl::item::render_info(defs_t defs) const {
     };
 }
 
+//------------------------------------------------------------------------------
+bool
+bkrl::item::can_stack_with(item const& other) const noexcept {
+    if (def_index != other.def_index || type != other.type) {
+        return false;
+    }
+
+    using it = item_type;
+
+    switch (type) {
+    case it::weapon : {
+        auto const& a = data.weapon;
+        auto const& b = other.data.weapon;
+        return a.dmg_min  == b.dmg_min
+            && a.dmg_max  == b.dmg_max
+            && a.dmg_type == b.dmg_type;
+    }
+    case it::armor :
+        return data.armor.base    == other.data.armor.base
+            && data.armor.resists == other.data.armor.resists;
+    case it::potion :
+        return data.potion.count == other.data.potion.count;
+    case it::none :
+        return true;
+    default :
+        break;
+    }
+
+    //containers and the like are never interchangeable
+    return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// group_items
+////////////////////////////////////////////////////////////////////////////////
+void
+bkrl::group_items(
+    item_id_view      const  items
+  , item_store        const& store
+  , std::vector<item_group>& out
+) {
+    out.clear();
+
+    if (items.empty()) {
+        return;
+    }
+
+    //order by definition, then id, so that candidates for a group are
+    //adjacent and the result doesn't depend on the order of items.
+    std::vector<item_id> sorted (std::begin(items), std::end(items));
+
+    std::sort(std::begin(sorted), std::end(sorted), [&](item_id const a, item_id const b) {
+        auto const ia = store[a].def_index;
+        auto const ib = store[b].def_index;
+        return (ia != ib) ? (ia < ib) : (a < b);
+    });
+
+    //items with the same definition rarely differ, so the number of groups
+    //per definition (and so the search below) is small.
+    auto first_of_def = size_t {0};
+
+    for (auto const id : sorted) {
+        auto const& itm = store[id];
+
+        if (first_of_def < out.size()
+         && store[out[first_of_def].id].def_index != itm.def_index
+        ) {
+            first_of_def = out.size();
+        }
+
+        auto const beg = std::begin(out) + static_cast<ptrdiff_t>(first_of_def);
+        auto const it  = std::find_if(beg, std::end(out), [&](item_group const& g) {
+            return store[g.id].can_stack_with(itm);
+        });
+
+        if (it != std::end(out)) {
+            ++it->count;
+        } else {
+            out.push_back(item_group {id, 1});
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// item_stack_summary
+////////////////////////////////////////////////////////////////////////////////
+
+//------------------------------------------------------------------------------
+bkrl::item_stack_summary::item_stack_summary(int const width, int const height)
+  : width_  {width}
+  , height_ {height}
+  , counts_ (static_cast<size_t>(width) * height, uint16_t {0})
+{
+    BK_ASSERT(width > 0 && height > 0);
+}
+
+//------------------------------------------------------------------------------
+void bkrl::item_stack_summary::update(
+    point_t                 const p
+  , item_map         const& map
+  , item_store       const& store
+  , item_definitions const& defs
+) {
+    auto const n = map.count_items_at(p);
+    BK_ASSERT(n >= 0 && n <= std::numeric_limits<uint16_t>::max());
+
+    counts_[index_(p)] = static_cast<uint16_t>(n);
+
+    auto const less = [](stack_t const& s, point_t const q) {
+        return item_map::record_t::less(s.pos, q);
+    };
+
+    auto const it    = std::lower_bound(std::begin(stacks_), std::end(stacks_), p, less);
+    auto const found = it != std::end(stacks_) && it->pos == p;
+
+    if (n == 0) {
+        if (found) {
+            stacks_.erase(it);
+        }
+
+        return;
+    }
+
+    auto info = item_render_info_t {};
+
+    if (n == 1) {
+        map.with_nth_at(p, 0, [&](item_id const itm) {
+            info = store[itm].render_info(defs);
+        });
+    } else {
+        info = defs.get_stack_info(n);
+    }
+
+    if (found) {
+        it->count = n;
+        it->info  = info;
+    } else {
+        stacks_.insert(it, stack_t {p, n, info});
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // item_store
 ////////////////////////////////////////////////////////////////////////////////
+//==============================================================================
+//! A set of generational slot maps; one per arena.
+//!
+//! Within an arena, items live contiguously in items_; removal moves the last
+//! item into the hole. An id names an arena and a slot within it; the slot
+//! knows where its item currently is, along with a generation that is bumped
+//! whenever the slot is freed so that stale ids can be told apart from live
+//! ones.
+//!
+//! Releasing an arena destroys its items and frees their memory all at once,
+//! and bumps the generation of every slot that was in use; the slots
+//! themselves are kept so that the arena can be handed out again without old
+//! ids coming back to life.
+//!
+//! id layout: [1 : tag][15 : arena][20 : generation][28 : slot index]
+//==============================================================================
 class bkrl::detail::item_store_impl {
 public:
     using rvalue          = item&&;
     using reference       = item&;
     using const_reference = item const&;
-    using key             = item_id; 
+    using key             = item_id;
+
+    using value_t = item_id::value_type;
+
+    enum : uint32_t {
+        index_bits       = 28
+      , generation_bits  = 20
+      , arena_bits       = 15
+      , index_mask       = (1u << index_bits) - 1
+      , generation_mask  = (1u << generation_bits) - 1
+      , arena_mask       = (1u << arena_bits) - 1
+      , generation_shift = index_bits
+      , arena_shift      = index_bits + generation_bits
+    };
+
+    static constexpr value_t tag_bit = value_t {1} << 63;
+
+    static_assert(1 + arena_bits + generation_bits + index_bits == 64, "");
+
+    static_assert(static_cast<size_t>(item_store::max_arenas) == size_t {arena_mask} + 1, "");
+    static_assert(item_store::max_arena_items == size_t {index_mask} + 1, "");
+
+    //! the global arena is always in use.
+    item_store_impl()
+      : arenas_(1)
+    {
+        arenas_.front().in_use = true;
+    }
+
+    item_arena create_arena() {
+        uint32_t a;
+        if (free_arenas_.empty()) {
+            a = static_cast<uint32_t>(arenas_.size());
+            if (a > arena_mask) {
+                BK_TODO_FAIL(); //out of arenas
+            }
 
-    key insert(rvalue value) {
-        auto const result_key = key {next_id_++};
+            arenas_.emplace_back();
+        } else {
+            a = free_arenas_.back();
+            free_arenas_.pop_back();
+        }
 
-        auto const result = data_.insert(std::make_pair(result_key, std::move(value)));
-        BK_ASSERT(result.second);
+        arenas_[a].in_use = true;
 
-        return result_key;
+        return item_arena {static_cast<uint16_t>(a)};
     }
 
-    void remove(key) {
+    void release_arena(item_arena const arena) {
+        auto const a = require_arena_(arena);
+        BK_ASSERT(a != 0); //the global arena is never released
+
+        arenas_[a].clear();
+        arenas_[a].in_use = false;
+
+        free_arenas_.push_back(a);
     }
 
-    reference       operator[](key const id)       { return require_at(data_, id); }
-    const_reference operator[](key const id) const { return require_at(data_, id); }
+    key insert(rvalue value, item_birthplace const& origin, item_arena const arena) {
+        auto const a     = require_arena_(arena);
+        auto const index = arenas_[a].insert(std::move(value), origin);
+
+        return make_key_(a, index, arenas_[a].slots_[index].generation);
+    }
+
+    void remove(key const id) {
+        auto const value = require_valid_(id);
+        arenas_[arena_of_(value)].remove(index_of_(value));
+    }
+
+    key move_to(key const id, item_arena const arena) {
+        auto const value = require_valid_(id);
+        auto const src   = arena_of_(value);
+        auto const dst   = require_arena_(arena);
+
+        if (src == dst) {
+            return id;
+        }
+
+        auto& from  = arenas_[src];
+        auto const dense = from.slots_[index_of_(value)].dense;
+
+        auto const result = insert(
+            std::move(from.items_[dense]), from.origins_[dense], arena);
+
+        //the contents follow the container; remove would drop them.
+        auto const it = from.contents_.find(index_of_(value));
+        if (it != std::end(from.contents_)) {
+            arenas_[dst].contents_[index_of_(id_to_value(result))] = std::move(it->second);
+        }
+
+        from.remove(index_of_(value));
+
+        return result;
+    }
+
+    item_arena arena_of(key const id) const {
+        return item_arena {static_cast<uint16_t>(arena_of_(require_valid_(id)))};
+    }
+
+    bool contains(key const id) const noexcept {
+        auto const value = id_to_value(id);
+        if (!(value & tag_bit)) {
+            return false;
+        }
+
+        auto const a = arena_of_(value);
+        if (a >= arenas_.size() || !arenas_[a].in_use) {
+            return false;
+        }
+
+        auto const& slots = arenas_[a].slots_;
+        auto const  index = index_of_(value);
+
+        return (index < slots.size())
+            && (slots[index].generation == (static_cast<uint32_t>(value >> generation_shift) & generation_mask));
+    }
+
+    size_t size() const noexcept {
+        return std::accumulate(std::begin(arenas_), std::end(arenas_), size_t {0}
+          , [](size_t const n, arena_t const& a) { return n + a.items_.size(); });
+    }
+
+    size_t size(item_arena const arena) const noexcept {
+        auto const a = id_to_value(arena);
+        return (a < arenas_.size()) ? arenas_[a].items_.size() : 0;
+    }
+
+    int arena_count() const noexcept {
+        return static_cast<int>(arenas_.size());
+    }
+
+    reference operator[](key const id) {
+        return arenas_[arena_of_(require_valid_(id))].get(id);
+    }
+
+    const_reference operator[](key const id) const {
+        return arenas_[arena_of_(require_valid_(id))].get(id);
+    }
+
+    item_birthplace const& origin(key const id) const {
+        auto const& a = arenas_[arena_of_(require_valid_(id))];
+        return a.origins_[a.slots_[index_of_(id_to_value(id))].dense];
+    }
+
+    item const* data(item_arena const arena) const noexcept {
+        auto const a = id_to_value(arena);
+        return (a < arenas_.size()) ? arenas_[a].items_.data() : nullptr;
+    }
+
+    item_collection& contents(key const id) {
+        auto const value = require_container_(id);
+        return arenas_[arena_of_(value)].contents_[index_of_(value)];
+    }
+
+    item_collection const& contents(key const id) const {
+        static item_collection const empty;
+
+        auto const  value = require_container_(id);
+        auto const& map   = arenas_[arena_of_(value)].contents_;
+        auto const  it    = map.find(index_of_(value));
+
+        return (it != std::end(map)) ? it->second : empty;
+    }
 private:
-    uint32_t next_id_ = 0x80000000;
-    std::unordered_map<key, item> data_;
+    struct slot_t {
+        uint32_t dense;      //!< index into items_ while in use
+        uint32_t generation; //!< bumped whenever the slot is freed
+    };
+
+    //--------------------------------------------------------------------------
+    //! The items belonging to one arena.
+    //--------------------------------------------------------------------------
+    struct arena_t {
+        //! @returns the slot index for @p value.
+        uint32_t insert(rvalue value, item_birthplace const& origin) {
+            auto const dense = static_cast<uint32_t>(items_.size());
+
+            uint32_t index;
+            if (free_.empty()) {
+                index = static_cast<uint32_t>(slots_.size());
+                if (index > index_mask) {
+                    BK_TODO_FAIL(); //out of ids
+                }
+
+                slots_.push_back(slot_t {dense, 0});
+            } else {
+                index = free_.back();
+                free_.pop_back();
+
+                slots_[index].dense = dense;
+            }
+
+            items_.push_back(std::move(value));
+            owners_.push_back(index);
+            origins_.push_back(origin);
+
+            return index;
+        }
+
+        void remove(uint32_t const index) {
+            auto&      slot  = slots_[index];
+            auto const dense = slot.dense;
+            auto const last  = static_cast<uint32_t>(items_.size() - 1);
+
+            if (dense != last) {
+                items_[dense]   = std::move(items_[last]);
+                owners_[dense]  = owners_[last];
+                origins_[dense] = origins_[last];
+
+                slots_[owners_[dense]].dense = dense;
+            }
+
+            items_.pop_back();
+            owners_.pop_back();
+            origins_.pop_back();
+
+            contents_.erase(index);
+
+            retire_(index);
+        }
+
+        //! remove every item at once.
+        void clear() {
+            for (auto const index : owners_) {
+                retire_(index);
+            }
+
+            //actually give the memory back; a released arena may sit unused
+            //for a long time.
+            decltype(items_)    {}.swap(items_);
+            decltype(owners_)   {}.swap(owners_);
+            decltype(origins_)  {}.swap(origins_);
+            decltype(contents_) {}.swap(contents_);
+        }
+
+        item& get(key const id) {
+            return items_[slots_[index_of_(id_to_value(id))].dense];
+        }
+
+        item const& get(key const id) const {
+            return items_[slots_[index_of_(id_to_value(id))].dense];
+        }
+
+        //! retire slots whose generation would wrap rather than risk an old id
+        //! coming back to life.
+        void retire_(uint32_t const index) {
+            if (++slots_[index].generation <= generation_mask) {
+                free_.push_back(index);
+            }
+        }
+
+        std::vector<item>            items_;
+        std::vector<uint32_t>        owners_;  //!< items_[i] belongs to slots_[owners_[i]]
+        std::vector<item_birthplace> origins_; //!< origins_[i] is that of items_[i]
+        std::vector<slot_t>          slots_;
+        std::vector<uint32_t>        free_;
+
+        //! the contents of the containers that have any, by slot index.
+        boost::container::flat_map<uint32_t, item_collection> contents_;
+
+        bool in_use = false;
+    };
+
+    static key make_key_(uint32_t const arena, uint32_t const index, uint32_t const generation) noexcept {
+        return key {tag_bit
+          | (value_t {arena}      << arena_shift)
+          | (value_t {generation} << generation_shift)
+          | value_t {index}};
+    }
+
+    static uint32_t arena_of_(value_t const value) noexcept {
+        return static_cast<uint32_t>(value >> arena_shift) & arena_mask;
+    }
+
+    static uint32_t index_of_(value_t const value) noexcept {
+        return static_cast<uint32_t>(value) & index_mask;
+    }
+
+    value_t require_valid_(key const id) const {
+        BK_ASSERT(contains(id));
+        return id_to_value(id);
+    }
+
+    value_t require_container_(key const id) const {
+        auto const value = require_valid_(id);
+        BK_ASSERT((*this)[id].type == item_type::container);
+        return value;
+    }
+
+    uint32_t require_arena_(item_arena const arena) const {
+        auto const a = static_cast<uint32_t>(id_to_value(arena));
+        BK_ASSERT(a < arenas_.size() && arenas_[a].in_use);
+        return a;
+    }
+
+    std::vector<arena_t>  arenas_;
+    std::vector<uint32_t> free_arenas_;
 };
 
+constexpr int    bkrl::item_store::max_arenas;
+constexpr size_t bkrl::item_store::max_arena_items;
+
 //------------------------------------------------------------------------------
 bkrl::item_store::item_store()
   : impl_ {std::make_unique<detail::item_store_impl>()}
@@ -465,10 +930,59 @@ bkrl::item_store::item_store()
 bkrl::item_store::~item_store() = default;
 bkrl::item_store::item_store(item_store&&) = default;
 
+//------------------------------------------------------------------------------
+bkrl::item_arena bkrl::item_store::create_arena() {
+    return impl_->create_arena();
+}
+
+//------------------------------------------------------------------------------
+void bkrl::item_store::release_arena(item_arena const arena) {
+    impl_->release_arena(arena);
+}
+
 //------------------------------------------------------------------------------
 bkrl::item_id
-bkrl::item_store::insert(rvalue value) {
-    return impl_->insert(std::move(value));
+bkrl::item_store::insert(
+    rvalue                 value
+  , item_birthplace const& origin
+  , item_arena      const  arena
+) {
+    return impl_->insert(std::move(value), origin, arena);
+}
+
+//------------------------------------------------------------------------------
+bkrl::item_id
+bkrl::item_store::move_to(item_id const id, item_arena const arena) {
+    return impl_->move_to(id, arena);
+}
+
+//------------------------------------------------------------------------------
+bkrl::item_arena
+bkrl::item_store::arena_of(item_id const id) const {
+    return impl_->arena_of(id);
+}
+
+//------------------------------------------------------------------------------
+bkrl::item_birthplace const&
+bkrl::item_store::origin(item_id const id) const {
+    return impl_->origin(id);
+}
+
+//------------------------------------------------------------------------------
+bkrl::item_collection&
+bkrl::item_store::contents(item_id const id) {
+    return impl_->contents(id);
+}
+
+bkrl::item_collection const&
+bkrl::item_store::contents(item_id const id) const {
+    return impl_->contents(id);
+}
+
+//------------------------------------------------------------------------------
+bkrl::item const*
+bkrl::item_store::data(item_arena const arena) const noexcept {
+    return impl_->data(arena);
 }
 
 //------------------------------------------------------------------------------
@@ -476,6 +990,26 @@ void bkrl::item_store::remove(item_id id) {
     impl_->remove(id);
 }
 
+//------------------------------------------------------------------------------
+bool bkrl::item_store::contains(item_id const id) const noexcept {
+    return impl_->contains(id);
+}
+
+//------------------------------------------------------------------------------
+size_t bkrl::item_store::size() const noexcept {
+    return impl_->size();
+}
+
+//------------------------------------------------------------------------------
+size_t bkrl::item_store::size(item_arena const arena) const noexcept {
+    return impl_->size(arena);
+}
+
+//------------------------------------------------------------------------------
+int bkrl::item_store::arena_count() const noexcept {
+    return impl_->arena_count();
+}
+
 //------------------------------------------------------------------------------
 bkrl::item_store::reference
 bkrl::item_store::operator[](item_id id) {
@@ -488,6 +1022,52 @@ bkrl::item_store::operator[](item_id id) const {
     return (*impl_)[id];
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// unique_item_arena
+////////////////////////////////////////////////////////////////////////////////
+
+//------------------------------------------------------------------------------
+bkrl::unique_item_arena::unique_item_arena(item_store& store)
+  : store_ {&store}
+  , arena_ {store.create_arena()}
+{
+}
+
+//------------------------------------------------------------------------------
+bkrl::unique_item_arena::unique_item_arena(unique_item_arena&& other) noexcept
+  : store_ {other.store_}
+  , arena_ {other.arena_}
+{
+    other.store_ = nullptr;
+}
+
+//------------------------------------------------------------------------------
+bkrl::unique_item_arena&
+bkrl::unique_item_arena::operator=(unique_item_arena&& rhs) noexcept {
+    if (this != &rhs) {
+        reset();
+
+        store_ = rhs.store_;
+        arena_ = rhs.arena_;
+
+        rhs.store_ = nullptr;
+    }
+
+    return *this;
+}
+
+//------------------------------------------------------------------------------
+bkrl::unique_item_arena::~unique_item_arena() {
+    reset();
+}
+
+//------------------------------------------------------------------------------
+void bkrl::unique_item_arena::reset() {
+    if (store_) {
+        store_->release_arena(arena_);
+        store_ = nullptr;
+    }
+}
 
 ////////////////////////////////////////////////////////////////////////////////
 // item_definitions
@@ -515,22 +1095,41 @@ public:
         return stack_info_;
     }
 
-    definition const& get_definition(item_def_id const id) const {
-        auto const it = definitions_.find(id);
-        if (it == std::end(definitions_)) {
+    //--------------------------------------------------------------------------
+    item_def_index index_of(item_def_id const id) const {
+        auto const index = definitions_.find(id);
+        if (!index) {
             BK_TODO_FAIL();
         }
 
-        return it->second;
+        return *index;
     }
-    
+
+    definition const& get_definition(item_def_index const index) const {
+        return definitions_[index];
+    }
+
+    definition const& get_definition(item_def_id const id) const {
+        return get_definition(index_of(id));
+    }
+
+    //--------------------------------------------------------------------------
+    locale const& get_locale(item_def_index const index) const {
+        auto const i = id_to_value(index);
+        if (i >= current_locale_.size()) {
+            return undefined_locale;
+        }
+
+        return *current_locale_[i];
+    }
+
     locale const& get_locale(item_def_id const id) const {
-        auto const it = current_locale_->find(id);
-        if (it == std::end(*current_locale_)) {
+        auto const index = definitions_.find(id);
+        if (!index) {
             return undefined_locale;
         }
 
-        return it->second;
+        return get_locale(*index);
     }
 
     void set_locale(lang_id const lang) {
@@ -539,19 +1138,17 @@ public:
             BK_TODO_FAIL();
         }
 
-        current_locale_ = &it->second;
+        current_lang_ = lang;
+        update_locale_table_();
     }
 
     auto get_definitions_size() const {
-        return static_cast<int>(definitions_.size());
+        return definitions_.size();
     }
     
     auto const& get_definition_at(int const index) const {
-        BK_ASSERT(index < get_definitions_size());
-
-        auto it = definitions_.begin();
-        std::advance(it, index);
-        return it->second;
+        BK_ASSERT(index >= 0 && index < get_definitions_size());
+        return definitions_[item_def_index {static_cast<uint16_t>(index)}];
     }
 
     ////////////////////////////////////////////////////////////////////////////
@@ -612,21 +1209,29 @@ public:
         auto const& defs  = json::require_array(value[jc::field_definitions]);
         auto const& array = defs.array_items();
 
-        definitions_.reserve(array.size());
+        definitions_.reserve(definitions_.size() + array.size());
         
         for (auto&& def : array) {
             rule_def_definition(def);
         }
+
+        update_locale_table_();
     }
 
     //--------------------------------------------------------------------------
     void rule_def_definition(cref value) {
+        //don't let anything optional leak over from the previous definition
+        cur_def_ = definition {};
+
         rule_def_id(value);
         rule_def_type(value);
         rule_def_tile(value);
         rule_def_weight(value);
 
-        definitions_.emplace(cur_def_.id, std::move(cur_def_));
+        auto const id = cur_def_.id;
+        if (!definitions_.insert(id, std::move(cur_def_))) {
+            BK_TODO_FAIL(); //duplicate definition
+        }
     }
 
     //--------------------------------------------------------------------------
@@ -798,6 +1403,8 @@ public:
         }
 
         locales_.emplace(cur_lang_, std::move(cur_loc_map_));
+
+        update_locale_table_();
     }
 
     void rule_loc_definition(cref value) {
@@ -824,15 +1431,38 @@ private:
 
     using locale_map = map_t<item_def_id, locale>;
 
+    //--------------------------------------------------------------------------
+    //! Line the strings for the current language up with definitions_ so
+    //! that they too can be found by index.
+    //--------------------------------------------------------------------------
+    void update_locale_table_() {
+        if (!current_lang_) {
+            return;
+        }
+
+        auto const& loc_map = locales_.find(*current_lang_)->second;
+
+        current_locale_.clear();
+        current_locale_.reserve(definitions_.size());
+
+        for (auto const& def : definitions_) {
+            auto const it = loc_map.find(def.id);
+            current_locale_.push_back(
+                (it != std::end(loc_map)) ? &it->second : &undefined_locale
+            );
+        }
+    }
+
     definition cur_def_;
     locale     cur_loc_;
     lang_id    cur_lang_;
     locale_map cur_loc_map_;
 
-    map_t<item_def_id, definition> definitions_;
-    map_t<lang_id,     locale_map> locales_;
+    definition_table<item_def_id, item_def_index, definition> definitions_;
+    map_t<lang_id, locale_map> locales_;
 
-    locale_map const* current_locale_ = nullptr;
+    optional<lang_id>          current_lang_;
+    std::vector<locale const*> current_locale_; //!< indexed by item_def_index
 
     item_render_info_t stack_info_;
 };
@@ -879,6 +1509,24 @@ bkrl::item_definitions::load_locale(json::cref data) {
     impl_->load_locale(data);
 }
 
+//------------------------------------------------------------------------------
+bkrl::item_def_index
+bkrl::item_definitions::index_of(item_def_id const id) const {
+    return impl_->index_of(id);
+}
+
+//------------------------------------------------------------------------------
+bkrl::item_definition const&
+bkrl::item_definitions::get_definition(item_def_index const index) const {
+    return impl_->get_definition(index);
+}
+
+//------------------------------------------------------------------------------
+bkrl::item_locale const&
+bkrl::item_definitions::get_locale(item_def_index const index) const {
+    return impl_->get_locale(index);
+}
+
 //------------------------------------------------------------------------------
 bkrl::item_definition const&
 bkrl::item_definitions::get_definition(item_def_id const id) const {
@@ -921,13 +1569,14 @@ bkrl::generate_item(
   , item_store&             store
   , item_definitions const& item_defs
   , item_birthplace  const  origin
+  , item_arena       const  arena
 ) {   
-    auto const& def = item_defs.get_definition(id);
+    auto const  index = item_defs.index_of(id);
+    auto const& def   = item_defs.get_definition(index);
 
     item itm;
-    itm.id     = def.id;;
-    itm.type   = def.type;
-    itm.origin = origin;
+    itm.def_index = index;
+    itm.type      = def.type;
 
     auto const make_weapon = [&] {
         BK_ASSERT(itm.type == item_type::weapon);
@@ -969,7 +1618,7 @@ bkrl::generate_item(
     case item_type::armor  : make_armor();  break;
     }
 
-    return store.insert(std::move(itm));
+    return store.insert(std::move(itm), origin, arena);
 }
 
 #ifdef BK_TEST
@@ -979,10 +1628,11 @@ bkrl::generate_item(
   , item_store&             store
   , item_definitions const& defs
 ) {
-    auto const& def = defs.get_definition(id);
+    auto const  index = defs.index_of(id);
+    auto const& def   = defs.get_definition(index);
     
     item itm;
-    itm.id = def.id;
+    itm.def_index = index;
     itm.type = def.type;
 
     return store.insert(std::move(itm));
@@ -1033,6 +1683,8 @@ public:
             slot = id;
         }
 
+        update_stats_(defs, items);
+
         return try_equip;
     }
 
@@ -1071,6 +1723,8 @@ public:
 
         flags_ &= ~def.slots;
 
+        update_stats_(defs, items);
+
         return id;
     }
 
@@ -1112,7 +1766,54 @@ public:
 
         return result;
     }
+
+    equipment_stats const& stats() const noexcept {
+        return stats_;
+    }
 private:
+    //--------------------------------------------------------------------------
+    //! Recompute stats_ from scratch; only done when the equipment changes.
+    //--------------------------------------------------------------------------
+    void update_stats_(defs_t defs, items_t items) {
+        stats_ = equipment_stats {};
+
+        auto const weapon = in_slot(equip_slot::hand_main)
+          ? in_slot(equip_slot::hand_main)
+          : in_slot(equip_slot::hand_off);
+
+        if (weapon && items[*weapon].type == item_type::weapon) {
+            auto const& w = items[*weapon].data.weapon;
+
+            stats_.dmg_min  = w.dmg_min;
+            stats_.dmg_max  = w.dmg_max;
+            stats_.dmg_type = w.dmg_type;
+        }
+
+        auto const first = std::cbegin(items_);
+        for (auto it = first; it != std::cend(items_); ++it) {
+            auto const id = *it;
+
+            //items occupying several slots only count once
+            if (id == item_id {} || std::find(first, it, id) != it) {
+                continue;
+            }
+
+            auto const& itm = items[id];
+
+            stats_.totals.add(itm.type, itm.weight(defs));
+
+            if (itm.type != item_type::armor) {
+                continue;
+            }
+
+            auto const& a = itm.data.armor;
+            for (size_t i = 0; i < a.resists.size(); ++i) {
+                //resists has no entry for damage_type::none
+                stats_.armor[i + 1] += static_cast<int16_t>(a.base * a.resists[i]);
+            }
+        }
+    }
+
     static size_t slot_to_index_(equip_slot const slot) {
         auto const result = static_cast<size_t>(enum_value(slot) - 1);
         BK_ASSERT(result < equip_size);
@@ -1140,6 +1841,8 @@ private:
     equip_slot_flags flags_;
 
     std::array<item_id, equip_size> items_;
+
+    equipment_stats stats_;
 };
 
 bkrl::equipment::equipment()
@@ -1183,3 +1886,7 @@ bkrl::equipment::match_any(equip_slot_flags const flags) const {
 bkrl::item_collection bkrl::equipment::list() const {
     return impl_->list();
 }
+
+bkrl::equipment_stats const& bkrl::equipment::stats() const noexcept {
+    return impl_->stats();
+}
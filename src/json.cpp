@@ -41,6 +41,10 @@ field_string const jc::field_slot             {"slot"};
 field_string const jc::field_player           {"player"};
 field_string const jc::field_armor_level      {"armor_level"};
 field_string const jc::field_weight           {"weight"};
+field_string const jc::field_speed            {"speed"};
+field_string const jc::field_sim_radius       {"sim_radius"};
+field_string const jc::field_sim_interval     {"sim_interval"};
+field_string const jc::field_spawns           {"spawns"};
 //------------------------------------------------------------------------------
 field_string const jc::filetype_config   {"CONFIG"};
 field_string const jc::filetype_locale   {"LOCALE"};
@@ -50,6 +54,7 @@ field_string const jc::filetype_tilemap  {"TILEMAP"};
 field_string const jc::filetype_keymap   {"KEYMAP"};
 field_string const jc::filetype_messages {"MESSAGE"};
 field_string const jc::filetype_loot     {"LOOT"};
+field_string const jc::filetype_spawn    {"SPAWN"};
 //------------------------------------------------------------------------------
 
 //------------------------------------------------------------------------------
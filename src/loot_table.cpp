@@ -1,10 +1,13 @@
 #include "loot_table.hpp"
 
-#include <boost/container/flat_map.hpp>
-
+#include "definition_table.hpp"
 #include "hash.hpp"
 #include "json.hpp"
 
+#include <boost/container/flat_map.hpp>
+
+#include <numeric>
+
 namespace bkrl {
 
 namespace json {
@@ -75,28 +78,6 @@ inline void assign(string_ref const src, utf8string& dst) {
     dst.assign(std::begin(src), std::end(src));
 }
 
-template <typename F, void (F::*)(size_t) const = &F::operator()>
-inline void repeat_n(size_t const n, F&& f) {
-    for (size_t i = 0; i < n; ++i) {
-        f(i);
-    }
-}
-
-template <typename F, void (F::*)() const = &F::operator()>
-inline void repeat_n(size_t const n, F&& f) {
-    for (size_t i = 0; i < n; ++i) {
-        f();
-    }
-}
-
-template <typename SrcCont, typename DstCont>
-inline void append_to(SrcCont const& src, DstCont& dst) {
-    using std::begin;
-    using std::end;
-
-    dst.insert(end(dst), begin(src), end(src));
-}
-
 //==============================================================================
 //! loot_table_parser_impl
 //==============================================================================
@@ -406,8 +387,7 @@ public:
             BK_TODO_FAIL();
         }
 
-        auto const result = tables_.emplace(id, std::move(table));
-        if (!result.second) {
+        if (!tables_.insert(id, std::move(table))) {
             BK_TODO_FAIL();
         }
     }
@@ -433,10 +413,7 @@ public:
 protected:
     detail::loot_table_parser_impl table_parser_;
 
-    template <typename K, typename V>
-    using map_t = boost::container::flat_map<K, V, std::less<>>;
-
-    map_t<loot_table_def_id, loot_table> tables_;
+    definition_table<loot_table_def_id, loot_table_def_index, loot_table> tables_;
 };
 
 } //namespace bkrl
@@ -465,122 +442,150 @@ bkrl::loot_table::loot_table(string_ref const table_name)
     assign(table_name, data.id_debug_string);
 
     rules_.push_back(std::move(data));
-}
 
-//--------------------------------------------------------------------------
-void bkrl::loot_table::generate(random_t& gen, defs_t defs, write_t const& write) const {
-    if (type_ == roll_t::roll_all) {
-        roll_all_(gen, defs, write);
-    } else if (type_ == roll_t::choose_one) {
-        choose_one_(gen, defs, write);
-    } else {
-        BK_TODO_FAIL();
-    }
+    tranform_data_();
 }
 
 //--------------------------------------------------------------------------
-void bkrl::loot_table::set_id(string_ref const id_str, loot_table_def_id const id) {
-    id_string_.assign(id_str.data(), id_str.size());
-    id_ = id;
+void bkrl::loot_table::generate_n(
+    random_t&   gen
+  , defs_t      defs
+  , size_t const n
+  , loot_batch& out
+) const {
+    out.offsets_.reserve(out.offsets_.size() + n);
+
+    auto const sink = [&](item_def_id const id, uint16_t const count) {
+        out.results_.push_back(loot_result_t {id, count});
+    };
+
+    for (size_t i = 0; i < n; ++i) {
+        out.offsets_.push_back(static_cast<uint32_t>(out.results_.size()));
+        generate(gen, defs, sink);
+    }
 }
 
 //--------------------------------------------------------------------------
-void bkrl::loot_table::tranform_data_() {
-    if (type_ != roll_t::choose_one) {
-        return;
-    }
+std::vector<bkrl::loot_expectation_t>
+bkrl::loot_table::expected_counts(defs_t defs) const {
+    boost::container::flat_map<hash_t, double> counts;
 
-    constexpr auto max = min_max_value<uint16_t>::max;
-        
-    uint32_t sum = 0;
+    auto sink = [&](item_def_id const id, double const count) {
+        counts[id_to_value(id)] += count;
+    };
 
-    for (auto& w : roll_data_) {
-        auto const new_w = w + sum;
+    expect_(defs, sink);
 
-        if (new_w > max) {
-            BK_TODO_FAIL();
-        }
+    std::vector<loot_expectation_t> result;
+    result.reserve(counts.size());
 
-        w   = static_cast<uint16_t>(new_w);
-        sum = w;
+    for (auto const& c : counts) {
+        result.push_back(loot_expectation_t {item_def_id {c.first}, c.second});
     }
+
+    return result;
 }
 
 //--------------------------------------------------------------------------
-void bkrl::loot_table::roll_all_(random_t& gen, defs_t defs, write_t const& write) const {
-    repeat_n(rules_.size(), [&](size_t const i) {
+//! Invokes sink(item_def_id, double) with the expected quantity each rule
+//! contributes; an item can be reported more than once. A nested table
+//! generated n times contributes E[n] times its own expectation as each time
+//! is independent of n.
+//--------------------------------------------------------------------------
+template <typename Sink>
+void bkrl::loot_table::expect_(defs_t defs, Sink& sink) const {
+    using id_t = loot_rule_data_t::id_t;
+
+    auto const size = rules_.size();
+
+    auto const total = (type_ == roll_t::choose_one)
+      ? static_cast<double>(alias_.total())
+      : 0.0;
+
+    for (size_t i = 0; i < size; ++i) {
         auto const& rule = rules_[i];
 
-        auto const num = roll_data_[i*2 + 0];
-        auto const den = roll_data_[i*2 + 1];
+        auto const p = (type_ == roll_t::roll_all)
+          ? std::min(1.0, static_cast<double>(roll_data_[i*2 + 0]) / roll_data_[i*2 + 1])
+          : static_cast<double>(roll_data_[i]) / total;
 
-        auto const lo = static_cast<uint16_t>(0);
-        auto const hi = static_cast<uint16_t>(den - 1);
+        auto const mean = (static_cast<double>(rule.count_lo) + rule.count_hi) / 2.0;
+        auto const n    = p * mean;
 
-        auto const roll = random::uniform_range(gen, lo, hi);
-        if (roll < num) {
-            roll_one_(gen, defs, rule, write);
+        if (rule.id_type == id_t::item_ref) {
+            sink(item_def_id {rule.id}, n);
+        } else if (rule.id_type == id_t::table_ref) {
+            BK_ASSERT_DBG(linked_);
+            for (auto const& e : defs.expected_counts(rule.table)) {
+                sink(e.id, n * e.count);
+            }
+        } else {
+            BK_TODO_FAIL();
         }
-    });
+    }
 }
-    
+
 //--------------------------------------------------------------------------
-void bkrl::loot_table::choose_one_(random_t& gen, defs_t defs, write_t const& write) const {
-    auto const find_index = [&](uint32_t const n) {
-        int i = 0;
-        for (auto const sum : roll_data_) {
-            if (n < sum) { return i; }
-            ++i;
-        }
+void bkrl::loot_table::link(defs_t defs) {
+    using id_t = loot_rule_data_t::id_t;
 
-        BK_TODO_FAIL();
-    };
+    for (auto& rule : rules_) {
+        while (rule.id_type == id_t::table_ref) {
+            rule.table = defs.index_of(loot_table_def_id {rule.id});
 
-    auto const  sum  = roll_data_.back();
-    auto const  roll = random::uniform_range<uint16_t>(gen, uint16_t {0}, sum - 1);
-    auto const  i    = find_index(roll);
-    auto const& rule = rules_[i];
+            //generating the table more (or less) than once isn't the same as
+            //generating its rule that many times.
+            if (rule.count_lo != 1 || rule.count_hi != 1) {
+                break;
+            }
 
-    roll_one_(gen, defs, rule, write);
-}
+            auto const only = defs[rule.table].only_rule();
+            if (!only) {
+                break;
+            }
 
-//--------------------------------------------------------------------------
-void bkrl::loot_table::roll_one_(random_t& gen, defs_t defs, rule_t rule, write_t const& write) const {
-    using id_t = loot_rule_data_t::id_t;
-        
-    if (rule.id_type == id_t::item_ref) {
-        roll_one_item_(gen, rule, write);
-    } else if (rule.id_type == id_t::table_ref) {
-        roll_one_table_(gen, defs, rule, write);
-    } else {
-        BK_TODO_FAIL();
+            rule = *only;
+        }
     }
+
+    linked_ = true;
 }
 
 //--------------------------------------------------------------------------
-void bkrl::loot_table::roll_one_item_(random_t& gen, rule_t rule, write_t const& write) const {
-    BK_ASSERT_DBG(rule.id_type == loot_rule_data_t::id_t::item_ref);
-
-    auto const id = item_def_id {rule.id};
-    auto const n  = random::uniform_range(gen, rule.count_lo, rule.count_hi);
+bkrl::loot_rule_data_t const* bkrl::loot_table::only_rule() const noexcept {
+    if (rules_.size() != 1) {
+        return nullptr;
+    }
 
-    if (n > 0) {
-        write(id, n);
+    if (type_ == roll_t::roll_all && roll_data_[0] < roll_data_[1]) {
+        return nullptr;
     }
+
+    return &rules_.front();
 }
 
 //--------------------------------------------------------------------------
-void bkrl::loot_table::roll_one_table_(random_t& gen, defs_t defs, rule_t rule, write_t const& write) const {
-    BK_ASSERT_DBG(rule.id_type == loot_rule_data_t::id_t::table_ref);
+void bkrl::loot_table::set_id(string_ref const id_str, loot_table_def_id const id) {
+    id_string_.assign(id_str.data(), id_str.size());
+    id_ = id;
+}
+
+//--------------------------------------------------------------------------
+void bkrl::loot_table::tranform_data_() {
+    if (type_ != roll_t::choose_one) {
+        return;
+    }
+
+    constexpr auto max = min_max_value<uint16_t>::max;
 
-    auto const id = loot_table_def_id {rule.id};
-    auto const n  = random::uniform_range(gen, rule.count_lo, rule.count_hi);
+    auto const sum = std::accumulate(
+        std::begin(roll_data_), std::end(roll_data_), uint32_t {0});
 
-    auto const& table = defs[id];
+    if (sum > max) {
+        BK_TODO_FAIL();
+    }
 
-    repeat_n(n, [&] {
-        table.generate(gen, defs, write);
-    });
+    alias_.build(roll_data_);
 }
 
 //==============================================================================
@@ -594,15 +599,132 @@ public:
     }
 
     //--------------------------------------------------------------------------
-    loot_table const& operator[](loot_table_def_id const id) const {
-        auto const result = tables_.find(id);
-        
-        if (result == std::cend(tables_)) {
+    void link(loot_table_definitions const& defs) {
+        if (find_cycle()) {
+            BK_TODO_FAIL();
+        }
+
+        for (auto& table : tables_) {
+            table.link(defs);
+        }
+
+        expectations_.clear();
+        expectations_.resize(static_cast<size_t>(tables_.size()));
+
+        std::vector<mark_t> marks(expectations_.size(), mark_t::none);
+        for (int i = 0; i < tables_.size(); ++i) {
+            expect_from_(loot_table_def_index {static_cast<uint16_t>(i)}, defs, marks);
+        }
+    }
+
+    //--------------------------------------------------------------------------
+    std::vector<loot_expectation_t> const& expected_counts(loot_table_def_index const index) const {
+        auto const i = static_cast<size_t>(id_to_value(index));
+        BK_ASSERT(i < expectations_.size());
+        return expectations_[i];
+    }
+
+    //--------------------------------------------------------------------------
+    optional<loot_table_def_id> find_cycle() const {
+        std::vector<mark_t> marks(static_cast<size_t>(tables_.size()), mark_t::none);
+
+        for (int i = 0; i < tables_.size(); ++i) {
+            auto const index = loot_table_def_index {static_cast<uint16_t>(i)};
+            if (auto const result = find_cycle_from_(index, marks)) {
+                return result;
+            }
+        }
+
+        return {};
+    }
+
+    //--------------------------------------------------------------------------
+    loot_table_def_index index_of(loot_table_def_id const id) const {
+        auto const index = tables_.find(id);
+        if (!index) {
             BK_TODO_FAIL();
         }
 
-        return result->second;
+        return *index;
+    }
+
+    //--------------------------------------------------------------------------
+    loot_table const& operator[](loot_table_def_index const index) const {
+        return tables_[index];
+    }
+
+    //--------------------------------------------------------------------------
+    loot_table const& operator[](loot_table_def_id const id) const {
+        return tables_[index_of(id)];
+    }
+
+    //--------------------------------------------------------------------------
+    int size() const noexcept {
+        return tables_.size();
+    }
+private:
+    enum class mark_t : uint8_t {
+        none, visiting, done
+    };
+
+    //--------------------------------------------------------------------------
+    //! Depth first from @p index; reaching a table that is still being visited
+    //! closes a cycle. References to undefined tables are left to link.
+    //--------------------------------------------------------------------------
+    optional<loot_table_def_id> find_cycle_from_(
+        loot_table_def_index const index
+      , std::vector<mark_t>&       marks
+    ) const {
+        auto& mark = marks[id_to_value(index)];
+
+        if (mark == mark_t::done) {
+            return {};
+        } else if (mark == mark_t::visiting) {
+            return tables_[index].id();
+        }
+
+        mark = mark_t::visiting;
+
+        optional<loot_table_def_id> result;
+        tables_[index].for_each_reference([&](loot_table_def_id const id) {
+            auto const next = tables_.find(id);
+            if (!result && next) {
+                result = find_cycle_from_(*next, marks);
+            }
+        });
+
+        mark = mark_t::done;
+
+        return result;
+    }
+
+    //--------------------------------------------------------------------------
+    //! Fill in expectations_ for @p index after those of the tables it refers
+    //! to, which loot_table::expected_counts reads back through @p defs.
+    //--------------------------------------------------------------------------
+    void expect_from_(
+        loot_table_def_index const   index
+      , loot_table_definitions const& defs
+      , std::vector<mark_t>&         marks
+    ) {
+        auto& mark = marks[id_to_value(index)];
+        if (mark == mark_t::done) {
+            return;
+        }
+
+        auto const& table = tables_[index];
+
+        table.for_each_rule([&](loot_rule_data_t const& rule) {
+            if (rule.id_type == loot_rule_data_t::id_t::table_ref) {
+                expect_from_(rule.table, defs, marks);
+            }
+        });
+
+        expectations_[id_to_value(index)] = table.expected_counts(defs);
+        mark = mark_t::done;
     }
+
+    std::vector<std::vector<loot_expectation_t>> expectations_; //!< by table index; set by link.
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -624,11 +746,39 @@ void bkrl::loot_table_definitions::load_definitions(json::cref data) {
     impl_->load_definitions(data);
 }
 
+void bkrl::loot_table_definitions::link() {
+    impl_->link(*this);
+}
+
+bkrl::optional<bkrl::loot_table_def_id>
+bkrl::loot_table_definitions::find_cycle() const {
+    return impl_->find_cycle();
+}
+
+bkrl::loot_table_def_index
+bkrl::loot_table_definitions::index_of(loot_table_def_id const id) const {
+    return impl_->index_of(id);
+}
+
+std::vector<bkrl::loot_expectation_t> const&
+bkrl::loot_table_definitions::expected_counts(loot_table_def_index const index) const {
+    return impl_->expected_counts(index);
+}
+
+bkrl::loot_table const&
+bkrl::loot_table_definitions::operator[](loot_table_def_index const index) const {
+    return (*impl_)[index];
+}
+
 bkrl::loot_table const&
 bkrl::loot_table_definitions::operator[](loot_table_def_id const id) const {
     return (*impl_)[id];
 }
 
+int bkrl::loot_table_definitions::size() const noexcept {
+    return impl_->size();
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // loot_table_parser
 ////////////////////////////////////////////////////////////////////////////////
@@ -29,6 +29,7 @@ bkrl::from_hash(hash_t const hash) {
       , {"get_no_items",     mt::get_no_items}
       , {"get_which_prompt", mt::get_which_prompt}
       , {"get_ok",           mt::get_ok}
+      , {"get_all_ok",       mt::get_all_ok}
 
       , {"drop_nothing",     mt::drop_nothing}
       , {"drop_ok",          mt::drop_ok}
@@ -44,6 +45,7 @@ bkrl::from_hash(hash_t const hash) {
       , {"title_take_off",   mt::title_take_off}
 
       , {"inventory_nothing", mt::inventory_nothing}
+      , {"inventory_weight",  mt::inventory_weight}
 
       , {"take_off_nothing", mt::take_off_nothing}
       , {"take_off_ok",      mt::take_off_ok}
@@ -84,6 +86,8 @@ bkrl::from_hash(hash_t const hash) {
       , {"itype_armor",  mt::itype_armor}
       , {"itype_potion", mt::itype_potion}
 
+      , {"debug_sim_stats", mt::debug_sim_stats}
+
     };
 
     return find_mapping(mappings, hash, mt::invalid);
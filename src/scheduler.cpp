@@ -0,0 +1,153 @@
+#include "scheduler.hpp"
+#include "assert.hpp"
+
+#include <algorithm>
+
+using bkrl::scheduler;
+
+////////////////////////////////////////////////////////////////////////////////
+// scheduler
+////////////////////////////////////////////////////////////////////////////////
+
+//------------------------------------------------------------------------------
+scheduler::time_t
+scheduler::delay_for(speed_t const speed, int const turns) noexcept {
+    BK_ASSERT_DBG(turns > 0);
+
+    auto const s = static_cast<time_t>(std::max<speed_t>(speed, speed_min));
+    auto const n = static_cast<time_t>(turns) * turn_length * speed_normal;
+
+    //round up so that no entity ever gets a delay of 0 (i.e. sleep).
+    return (n + s - 1) / s;
+}
+
+//------------------------------------------------------------------------------
+void scheduler::insert(entity_id const id, time_t const delay) {
+    auto const result = index_.emplace(id_to_value(id), 0u);
+    auto const it     = result.first;
+
+    if (result.second) {
+        if (free_slots_.empty()) {
+            it->second = static_cast<uint32_t>(slots_.size());
+            slots_.push_back(slot_t {id, free_ticket, 0});
+        } else {
+            it->second = free_slots_.back();
+            free_slots_.pop_back();
+            slots_[it->second].id = id;
+        }
+    }
+
+    //any existing record for the slot becomes stale.
+    push_(it->second, now_ + delay);
+}
+
+//------------------------------------------------------------------------------
+bool scheduler::remove(entity_id const id) {
+    auto const it = index_.find(id_to_value(id));
+    if (it == std::end(index_)) {
+        return false;
+    }
+
+    auto const slot = it->second;
+
+    slots_[slot].ticket = free_ticket;
+    free_slots_.push_back(slot);
+    index_.erase(it);
+
+    //the heap entry is left in place and skipped when popped; only compact
+    //when stale entries start to dominate.
+    if (heap_.size() > 32 && heap_.size() > index_.size() * 2) {
+        compact_();
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+bool scheduler::is_scheduled(entity_id const id) const {
+    return index_.find(id_to_value(id)) != std::end(index_);
+}
+
+//------------------------------------------------------------------------------
+bkrl::optional<scheduler::time_t>
+scheduler::next_time(entity_id const id) const {
+    auto const it = index_.find(id_to_value(id));
+    if (it == std::end(index_)) {
+        return {};
+    }
+
+    return slots_[it->second].time;
+}
+
+//------------------------------------------------------------------------------
+bool scheduler::pop_due_(time_t const until, record_t& out) {
+    while (!heap_.empty()) {
+        if (heap_.front().time > until) {
+            return false;
+        }
+
+        std::pop_heap(std::begin(heap_), std::end(heap_), later_t {});
+        out = heap_.back();
+        heap_.pop_back();
+
+        if (is_live_(out)) {
+            return true;
+        }
+
+        //stale; removed or rescheduled since it was pushed.
+    }
+
+    return false;
+}
+
+//------------------------------------------------------------------------------
+bool scheduler::pop_all_due_(time_t const until) {
+    batch_.clear();
+
+    record_t rec;
+    if (!pop_due_(until, rec)) {
+        return false;
+    }
+
+    //only those due at the same time; anything later might yet be preceded by
+    //an entity in this batch coming due again.
+    auto const time = rec.time;
+
+    do {
+        batch_.push_back(rec);
+    } while (pop_due_(time, rec));
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+void scheduler::reinsert_(record_t const& rec, time_t const delay) {
+    //removed or explicitly rescheduled while it was acting.
+    if (!is_live_(rec)) {
+        return;
+    }
+
+    push_(rec.slot, rec.time + delay);
+}
+
+//------------------------------------------------------------------------------
+void scheduler::push_(uint32_t const slot, time_t const time) {
+    auto const ticket = next_ticket_++;
+
+    auto& s = slots_[slot];
+    s.ticket = ticket;
+    s.time   = time;
+
+    heap_.push_back(record_t {time, ticket, slot});
+    std::push_heap(std::begin(heap_), std::end(heap_), later_t {});
+}
+
+//------------------------------------------------------------------------------
+void scheduler::compact_() {
+    auto const end = std::remove_if(std::begin(heap_), std::end(heap_)
+      , [&](record_t const& rec) { return !is_live_(rec); }
+    );
+
+    heap_.erase(end, std::end(heap_));
+    std::make_heap(std::begin(heap_), std::end(heap_), later_t {});
+}
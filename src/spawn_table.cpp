@@ -0,0 +1,243 @@
+#include "spawn_table.hpp"
+
+#include "definition_table.hpp"
+#include "entity.hpp"
+#include "hash.hpp"
+#include "json.hpp"
+
+#include <algorithm>
+
+namespace jc = bkrl::json::common;
+
+constexpr uint16_t bkrl::spawn_rule_t::open_depth;
+
+namespace bkrl {
+
+//==============================================================================
+//! spawn_table_parser
+//!
+//! A table is an object with an id and a list of spawns, each of which is
+//! [weight, entity], [weight, entity, depth_lo] or
+//! [weight, entity, depth_lo, depth_hi].
+//==============================================================================
+class spawn_table_parser {
+public:
+    enum : size_t {
+        index_weight   = 0
+      , index_id       = 1
+      , index_depth_lo = 2
+      , index_depth_hi = 3
+    };
+
+    //--------------------------------------------------------------------------
+    spawn_rule_t rule_spawn(json::cref value) const {
+        json::require_array(value, 2, 4);
+
+        auto const size = value.array_items().size();
+
+        spawn_rule_t rule;
+
+        rule.id     = entity_def_id {slash_hash32(json::require_string(value[index_id]))};
+        rule.weight = json::require_int<uint16_t>(value[index_weight]);
+
+        rule.depth_lo = (size > index_depth_lo)
+          ? json::require_int<uint16_t>(value[index_depth_lo])
+          : uint16_t {0};
+
+        if (size > index_depth_hi) {
+            rule.depth_hi = json::require_int<uint16_t>(value[index_depth_hi]);
+
+            //would be taken for no depth_hi at all
+            if (rule.depth_hi == spawn_rule_t::open_depth) {
+                BK_TODO_FAIL();
+            }
+        } else {
+            rule.depth_hi = spawn_rule_t::open_depth;
+        }
+
+        if (rule.weight == 0 || rule.depth_hi < rule.depth_lo) {
+            BK_TODO_FAIL();
+        }
+
+        return rule;
+    }
+
+    //--------------------------------------------------------------------------
+    spawn_table rule_definition(json::cref value) const {
+        json::require_object(value);
+
+        auto const  id_str = jc::get_id_string(value);
+        auto const& spawns = json::require_array(value[jc::field_spawns], 1);
+
+        std::vector<spawn_rule_t> rules;
+        rules.reserve(spawns.array_items().size());
+
+        for (json::cref spawn : spawns.array_items()) {
+            rules.push_back(rule_spawn(spawn));
+        }
+
+        return spawn_table {
+            id_str, spawn_table_def_id {slash_hash32(id_str)}, std::move(rules)};
+    }
+};
+
+} //namespace bkrl
+
+////////////////////////////////////////////////////////////////////////////////
+// spawn_table
+////////////////////////////////////////////////////////////////////////////////
+
+//------------------------------------------------------------------------------
+bkrl::spawn_table::spawn_table(
+    string_ref                const id_str
+  , spawn_table_def_id        const id
+  , std::vector<spawn_rule_t>       rules
+)
+  : rules_     (std::move(rules))
+  , id_string_ (id_str.data(), id_str.size())
+  , id_        {id}
+{
+}
+
+//------------------------------------------------------------------------------
+void bkrl::spawn_table::link(entity_definitions const& entity_defs) {
+    std::vector<entity_def_index> indices;
+    indices.reserve(rules_.size());
+
+    //the same rules apply to every depth from one point where a rule starts,
+    //or the one after a rule ends, up to the next.
+    starts_.clear();
+    starts_.push_back(0);
+
+    for (auto const& rule : rules_) {
+        indices.push_back(entity_defs.index_of(rule.id));
+
+        starts_.push_back(rule.depth_lo);
+        if (rule.depth_hi != spawn_rule_t::open_depth) {
+            starts_.push_back(rule.depth_hi + 1);
+        }
+    }
+
+    std::sort(std::begin(starts_), std::end(starts_));
+    starts_.erase(std::unique(std::begin(starts_), std::end(starts_)), std::end(starts_));
+
+    depths_.clear();
+    depths_.resize(starts_.size());
+
+    std::vector<uint16_t> weights;
+
+    for (size_t run = 0; run < starts_.size(); ++run) {
+        auto const depth = starts_[run];
+        auto&      table = depths_[run];
+
+        weights.clear();
+
+        for (size_t i = 0; i < rules_.size(); ++i) {
+            auto const& rule = rules_[i];
+            if (depth < rule.depth_lo || depth > rule.depth_hi) {
+                continue;
+            }
+
+            table.entities.push_back(indices[i]);
+            weights.push_back(rule.weight);
+        }
+
+        if (!weights.empty()) {
+            table.alias.build(weights);
+        }
+    }
+
+    linked_ = true;
+}
+
+//==============================================================================
+//! spawn_table_definitions_impl
+//==============================================================================
+class bkrl::detail::spawn_table_definitions_impl {
+public:
+    //--------------------------------------------------------------------------
+    void load_definitions(json::cref data) {
+        json::require_object(data);
+        jc::get_filetype(data, jc::filetype_spawn);
+
+        auto const& defs = json::require_array(data[jc::field_definitions]);
+
+        for (json::cref def : defs.array_items()) {
+            auto table = parser_.rule_definition(def);
+            auto const id = table.id();
+
+            if (!tables_.insert(id, std::move(table))) {
+                BK_TODO_FAIL();
+            }
+        }
+    }
+
+    //--------------------------------------------------------------------------
+    void link(entity_definitions const& entity_defs) {
+        for (auto& table : tables_) {
+            table.link(entity_defs);
+        }
+    }
+
+    //--------------------------------------------------------------------------
+    spawn_table const* find(spawn_table_def_id const id) const {
+        auto const index = tables_.find(id);
+        return index ? &tables_[*index] : nullptr;
+    }
+
+    //--------------------------------------------------------------------------
+    spawn_table const& operator[](spawn_table_def_id const id) const {
+        auto const result = find(id);
+        if (!result) {
+            BK_TODO_FAIL();
+        }
+
+        return *result;
+    }
+
+    //--------------------------------------------------------------------------
+    int size() const noexcept {
+        return tables_.size();
+    }
+private:
+    spawn_table_parser parser_;
+
+    definition_table<spawn_table_def_id, spawn_table_def_index, spawn_table> tables_;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// spawn_table_definitions
+////////////////////////////////////////////////////////////////////////////////
+bkrl::spawn_table_definitions::~spawn_table_definitions() = default;
+
+bkrl::spawn_table_definitions::spawn_table_definitions(spawn_table_definitions&&) = default;
+
+bkrl::spawn_table_definitions&
+bkrl::spawn_table_definitions::operator=(spawn_table_definitions&&) = default;
+
+bkrl::spawn_table_definitions::spawn_table_definitions()
+  : impl_ {std::make_unique<detail::spawn_table_definitions_impl>()}
+{
+}
+
+void bkrl::spawn_table_definitions::load_definitions(json::cref data) {
+    impl_->load_definitions(data);
+}
+
+void bkrl::spawn_table_definitions::link(entity_definitions const& entity_defs) {
+    impl_->link(entity_defs);
+}
+
+bkrl::spawn_table const*
+bkrl::spawn_table_definitions::find(spawn_table_def_id const id) const {
+    return impl_->find(id);
+}
+
+bkrl::spawn_table const&
+bkrl::spawn_table_definitions::operator[](spawn_table_def_id const id) const {
+    return (*impl_)[id];
+}
+
+int bkrl::spawn_table_definitions::size() const noexcept {
+    return impl_->size();
+}
@@ -0,0 +1,170 @@
+#include "thread_pool.hpp"
+#include "assert.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//==============================================================================
+//!
+//==============================================================================
+class bkrl::detail::thread_pool_impl {
+public:
+    using chunk_function = thread_pool::chunk_function;
+
+    //--------------------------------------------------------------------------
+    explicit thread_pool_impl(unsigned threads) {
+        if (threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        workers_.reserve(threads - 1);
+        for (unsigned i = 1; i < threads; ++i) {
+            workers_.emplace_back([this] { worker_(); });
+        }
+    }
+
+    //--------------------------------------------------------------------------
+    ~thread_pool_impl() {
+        {
+            std::lock_guard<std::mutex> lock {mutex_};
+            stop_ = true;
+        }
+
+        work_cv_.notify_all();
+
+        for (auto& t : workers_) {
+            t.join();
+        }
+    }
+
+    //--------------------------------------------------------------------------
+    unsigned size() const noexcept {
+        return static_cast<unsigned>(workers_.size()) + 1;
+    }
+
+    //--------------------------------------------------------------------------
+    void parallel_for(
+        size_t const n
+      , size_t const min_chunk
+      , chunk_function const& function
+    ) {
+        if (n == 0) {
+            return;
+        }
+
+        //not worth waking anyone up for
+        if (workers_.empty() || n <= min_chunk) {
+            function(0, n);
+            return;
+        }
+
+        //a few chunks per thread to even out the load
+        auto const chunks = static_cast<size_t>(size()) * 4;
+        auto const chunk  = std::max<size_t>({1, min_chunk, (n + chunks - 1) / chunks});
+
+        {
+            std::lock_guard<std::mutex> lock {mutex_};
+
+            BK_ASSERT(function_ == nullptr); //not reentrant
+
+            function_ = &function;
+            size_     = n;
+            chunk_    = chunk;
+            next_     = 0;
+            active_   = static_cast<unsigned>(workers_.size());
+
+            ++generation_;
+        }
+
+        work_cv_.notify_all();
+
+        run_chunks_();
+
+        std::unique_lock<std::mutex> lock {mutex_};
+        done_cv_.wait(lock, [&] { return active_ == 0; });
+
+        function_ = nullptr;
+    }
+private:
+    //--------------------------------------------------------------------------
+    void run_chunks_() {
+        for (;;) {
+            auto const first = next_.fetch_add(chunk_);
+            if (first >= size_) {
+                break;
+            }
+
+            (*function_)(first, std::min(first + chunk_, size_));
+        }
+    }
+
+    //--------------------------------------------------------------------------
+    void worker_() {
+        auto seen = uint64_t {0};
+
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock {mutex_};
+                work_cv_.wait(lock, [&] { return stop_ || generation_ != seen; });
+
+                if (stop_) {
+                    return;
+                }
+
+                seen = generation_;
+            }
+
+            run_chunks_();
+
+            std::lock_guard<std::mutex> lock {mutex_};
+            if (--active_ == 0) {
+                done_cv_.notify_one();
+            }
+        }
+    }
+
+    std::vector<std::thread> workers_;
+
+    std::mutex              mutex_;
+    std::condition_variable work_cv_;
+    std::condition_variable done_cv_;
+
+    chunk_function const* function_   = nullptr;
+    size_t                size_       = 0;
+    size_t                chunk_      = 0;
+    std::atomic<size_t>   next_       {0};
+    unsigned              active_     = 0;
+    uint64_t              generation_ = 0;
+    bool                  stop_       = false;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// thread_pool
+////////////////////////////////////////////////////////////////////////////////
+
+//------------------------------------------------------------------------------
+bkrl::thread_pool::thread_pool(unsigned const threads)
+  : impl_ {std::make_unique<detail::thread_pool_impl>(threads)}
+{
+}
+
+//------------------------------------------------------------------------------
+bkrl::thread_pool::~thread_pool() = default;
+
+//------------------------------------------------------------------------------
+unsigned bkrl::thread_pool::size() const noexcept {
+    return impl_->size();
+}
+
+//------------------------------------------------------------------------------
+void bkrl::thread_pool::parallel_for(
+    size_t const n
+  , size_t const min_chunk
+  , chunk_function const& function
+) {
+    impl_->parallel_for(n, min_chunk, function);
+}
@@ -74,6 +74,16 @@ unique_file open_file(bkrl::path_string_ref const filename) {
 
     return unique_file {result};
 }
+#else
+unique_file open_file(bkrl::path_string_ref const filename) {
+    //path_char is char; the name is already utf8.
+    auto const result = std::fopen(filename.to_string().c_str(), "rb");
+    if (result == nullptr) {
+        BK_TODO_FAIL();
+    }
+
+    return unique_file {result};
+}
 #endif
 
 //------------------------------------------------------------------------------
@@ -0,0 +1,57 @@
+#include "catch/catch.hpp"
+#include "background_worker.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using bkrl::background_worker;
+
+TEST_CASE("background_worker runs tasks in order", "[background_worker]") {
+    background_worker worker;
+
+    REQUIRE(worker.is_idle());
+
+    std::vector<int> order;
+    std::atomic<bool> other_thread {true};
+
+    auto const main_id = std::this_thread::get_id();
+
+    for (int i = 0; i < 100; ++i) {
+        worker.post([&, i] {
+            if (std::this_thread::get_id() == main_id) {
+                other_thread = false;
+            }
+
+            order.push_back(i);
+        });
+    }
+
+    worker.sync();
+
+    REQUIRE(worker.is_idle());
+    REQUIRE(other_thread);
+    REQUIRE(order.size() == 100);
+
+    for (int i = 0; i < 100; ++i) {
+        REQUIRE(order[i] == i);
+    }
+}
+
+TEST_CASE("background_worker finishes tasks before destruction", "[background_worker]") {
+    std::atomic<int> count {0};
+
+    {
+        background_worker worker;
+
+        for (int i = 0; i < 10; ++i) {
+            worker.post([&] {
+                std::this_thread::sleep_for(std::chrono::milliseconds {1});
+                ++count;
+            });
+        }
+    }
+
+    REQUIRE(count == 10);
+}
@@ -0,0 +1,53 @@
+//##############################################################################
+//! @file
+//! @author Brandon Kentel
+//!
+//! Timing shared by the hidden [benchmark] test cases.
+//##############################################################################
+#pragma once
+
+#include "catch/catch.hpp"
+#include "time.hpp"
+
+#include <chrono>
+
+////////////////////////////////////////////////////////////////////////////////
+namespace bkrl {
+////////////////////////////////////////////////////////////////////////////////
+
+//==============================================================================
+//! The time since construction or the last restart, on the same clock as
+//! bkrl::timer.
+//==============================================================================
+class stopwatch {
+public:
+    using clock_t = timer::clock_t;
+    using ms_t    = std::chrono::duration<double, std::milli>;
+
+    stopwatch() noexcept
+      : start_ {clock_t::now()}
+    {
+    }
+
+    void restart() noexcept {
+        start_ = clock_t::now();
+    }
+
+    //! The milliseconds elapsed, divided by @p repeat.
+    double elapsed_ms(int const repeat = 1) const noexcept {
+        return ms_t {clock_t::now() - start_}.count() / repeat;
+    }
+
+    //! WARN "<name><ms> ms", per each of @p repeat runs, and restart for the
+    //! next measurement.
+    void report(char const* const name, int const repeat = 1) {
+        WARN(name << elapsed_ms(repeat) << " ms");
+        restart();
+    }
+private:
+    clock_t::time_point start_;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+} //namespace bkrl
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,188 @@
+#include "catch/catch.hpp"
+#include "entity.hpp"
+#include "random.hpp"
+#include "scheduler.hpp"
+#include "thread_pool.hpp"
+#include "benchmark.hpp"
+
+#include <thread>
+#include <vector>
+
+namespace {
+
+//! a map of @p n entities, with ids 1 to n, scattered over a size x size grid.
+bkrl::entity_map make_entity_map(bkrl::random_t& gen, int const size, uint32_t const n) {
+    bkrl::entity_map result;
+
+    for (uint32_t i = 1; i <= n; ++i) {
+        bkrl::entity ent;
+        ent.instance_id = bkrl::entity_id {i};
+
+        for (;;) {
+            auto const p = bkrl::ipoint2 {
+                bkrl::random::uniform_range(gen, 0, size - 1)
+              , bkrl::random::uniform_range(gen, 0, size - 1)
+            };
+
+            if (result.insert_at(p, std::move(ent))) {
+                break;
+            }
+        }
+    }
+
+    return result;
+}
+
+} //namespace
+
+TEST_CASE("entity_map position index", "[entity]") {
+    using bkrl::entity;
+    using bkrl::entity_id;
+    using bkrl::ipoint2;
+    using bkrl::ivec2;
+
+    constexpr auto     size  = 64;
+    constexpr uint32_t count = 500;
+
+    bkrl::random_t gen {1234};
+    auto map = make_entity_map(gen, size, count);
+
+    REQUIRE(map.size() == count);
+
+    auto const check_all = [&] {
+        auto ok = true;
+        map.for_each([&](entity const& e) {
+            auto const found = map.at(e.position());
+            ok = ok && found && (*found == e);
+        });
+
+        return ok;
+    };
+
+    REQUIRE(check_all());
+
+    for (int i = 0; i < 5000; ++i) {
+        auto const id = entity_id {bkrl::random::uniform_range(gen, 1u, count)};
+        auto const v  = ivec2 {
+            bkrl::random::uniform_range(gen, -3, 3)
+          , bkrl::random::uniform_range(gen, -3, 3)
+        };
+
+        auto from = ipoint2 {};
+        auto to   = ipoint2 {};
+
+        map.with_entity(id, [&](entity& e) {
+            from = e.position();
+            to   = from + v;
+
+            if (to == from || map.at(to)) {
+                to = from;
+                return;
+            }
+
+            //as level::try_move does; the nested call moves it first
+            if (i % 2) {
+                map.with_entity_at(from, [&](entity& e0) { e0.move_by(v); });
+            } else {
+                e.move_by(v);
+            }
+        });
+
+        auto const at_to = map.at(to);
+        REQUIRE(!!at_to);
+        REQUIRE(at_to->instance_id == id);
+
+        if (to != from) {
+            REQUIRE(!map.at(from));
+        }
+    }
+
+    REQUIRE(check_all());
+}
+
+//------------------------------------------------------------------------------
+//! One turn of a large level, as level::advance does it: entities with mixed
+//! speeds decide across a thread pool and then move one at a time. Reports the
+//! time per turn for each thread count, and how many entities each batch
+//! handed to the pool held on average.
+//------------------------------------------------------------------------------
+TEST_CASE("entity_map level benchmark", "[.][benchmark][entity]") {
+    using bkrl::entity;
+    using bkrl::entity_id;
+    using bkrl::ivec2;
+    using bkrl::scheduler;
+
+    constexpr auto     size  = 250;
+    constexpr uint32_t count = 10000;
+    constexpr auto     turns = 100;
+    constexpr uint32_t seed  = 1234;
+
+    //counts the batches handed to the pool.
+    struct counting_pool {
+        void parallel_for(size_t const n, size_t const min_chunk
+          , bkrl::thread_pool::chunk_function const& f
+        ) {
+            ++batches;
+            entities += n;
+            pool->parallel_for(n, min_chunk, f);
+        }
+
+        bkrl::thread_pool* pool;
+        size_t batches;
+        size_t entities;
+    };
+
+    auto const speed_of = [](entity_id const id) {
+        return static_cast<bkrl::speed_t>(75 + id_to_value(id) % 4 * 25);
+    };
+
+    auto const hw = std::max(1u, std::thread::hardware_concurrency());
+
+    for (unsigned threads = 1; threads <= hw; threads *= 2) {
+        bkrl::thread_pool pool {threads};
+        counting_pool counter {&pool, 0, 0};
+
+        bkrl::random_t gen {seed};
+        auto map = make_entity_map(gen, size, count);
+
+        scheduler sched;
+        map.for_each([&](entity const& e) {
+            sched.insert(e.instance_id, scheduler::delay_for(speed_of(e.instance_id)));
+        });
+
+        std::vector<ivec2> intents;
+
+        bkrl::stopwatch watch;
+        for (int t = 0; t < turns; ++t) {
+            auto const& ents = map;
+
+            sched.advance_parallel(scheduler::turn_length, counter, 64, intents
+              , [&](entity_id const id, scheduler::time_t const time) {
+                    auto v = ivec2 {};
+                    ents.with_entity(id, [&](entity const&) {
+                        auto g = bkrl::random::philox4x32 {seed}.derive(time).derive(id_to_value(id));
+                        v = bkrl::random::direction(g);
+                    });
+
+                    return v;
+                }
+              , [&](entity_id const id, ivec2 const v) {
+                    map.with_entity(id, [&](entity& e) {
+                        auto const p = e.position();
+                        auto const q = p + v;
+
+                        if (q.x < 0 || q.x >= size || q.y < 0 || q.y >= size || map.at(q)) {
+                            return;
+                        }
+
+                        map.with_entity_at(p, [&](entity& e0) { e0.move_by(v); });
+                    });
+
+                    return scheduler::delay_for(speed_of(id));
+                }
+            );
+        }
+        WARN(threads << " threads: " << watch.elapsed_ms(turns) << " ms per turn; "
+          << static_cast<double>(counter.entities) / counter.batches << " entities per batch");
+    }
+}
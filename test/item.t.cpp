@@ -2,6 +2,9 @@
 #include "items.hpp"
 #include "json.hpp"
 #include "random.hpp"
+#include "benchmark.hpp"
+
+#include <unordered_map>
 
 ////////////////////////////////////////////////////////////////////////////////
 namespace {
@@ -9,17 +12,26 @@ namespace {
 static bkrl::utf8string const test_item_defs
 {R"(
     { "file_type": "ITEM"
+    , "file_name": "./data/items.bmp"
+    , "tile_size": [18, 18]
     , "definitions": [
         { "id": "TEST_ITEM0"
+        , "tile": [0, 0]
         , "type": "weapon"
         , "slot": ["hand_main", "hand_off"]
+        , "weight": 10
         }
       , { "id": "TEST_ITEM1"
+        , "tile": [1, 0]
         , "type": "armor"
         , "slot": ["head"]
+        , "armor_level": ["uniform", 1, 3]
+        , "weight": 10
         }
       , { "id": "TEST_ITEM2"
+        , "tile": [2, 0]
         , "type": "potion"
+        , "weight": 10
         }
       ]
     }
@@ -57,6 +69,14 @@ static bkrl::item_definitions make_defs() {
 
     return result;
 }
+//! an item of the index'th definition, in load order; see make_defs.
+static bkrl::item make_item(int const index) {
+    bkrl::item result;
+    result.def_index = bkrl::item_def_index {static_cast<uint16_t>(index)};
+    result.type      = bkrl::item_type::none;
+
+    return result;
+}
 ////////////////////////////////////////////////////////////////////////////////
 } //namespace
 ////////////////////////////////////////////////////////////////////////////////
@@ -73,6 +93,38 @@ TEST_CASE("item localized names", "[item]") {
     REQUIRE(item_defs.get_locale(item_id2).name == "test item 2");
 }
 
+TEST_CASE("item definition indices", "[item]") {
+    using namespace bkrl;
+
+    auto item_defs = make_defs();
+    auto istore    = item_store {};
+
+    item_defs.set_locale(BK_MAKE_LANG_CODE2('e','n'));
+
+    //indices are dense and follow the order the definitions were loaded in
+    auto const index0 = item_defs.index_of(item_id0);
+    auto const index1 = item_defs.index_of(item_id1);
+    auto const index2 = item_defs.index_of(item_id2);
+
+    REQUIRE(id_to_value(index0) == 0);
+    REQUIRE(id_to_value(index1) == 1);
+    REQUIRE(id_to_value(index2) == 2);
+
+    REQUIRE(&item_defs.get_definition(index1) == &item_defs.get_definition(item_id1));
+    REQUIRE(&item_defs.get_definition(index2) == &item_defs.get_definition_at(2));
+    REQUIRE(&item_defs.get_locale(index1)     == &item_defs.get_locale(item_id1));
+
+    //instances carry the index of their definition
+    auto const id = generate_item(item_id1, istore, item_defs);
+    auto const& itm = istore[id];
+
+    REQUIRE(itm.def_index == index1);
+    REQUIRE(itm.name(item_defs) == "test item 1");
+
+    //unknown ids have no strings, but are still safe to ask about
+    REQUIRE(item_defs.get_locale(item_def_id {1}).name == "{undefined name}");
+}
+
 TEST_CASE("equipment sanity check", "[item]") {
     using namespace bkrl;
 
@@ -107,3 +159,721 @@ TEST_CASE("equipment sanity check", "[item]") {
     REQUIRE(!equip.in_slot(equip_slot::hand_off));
 }
 
+
+TEST_CASE("equipment stats", "[item]") {
+    using namespace bkrl;
+
+    auto item_defs = make_defs();
+    auto istore    = item_store {};
+    auto equip     = equipment {};
+
+    auto const sword  = generate_item(item_id0, istore, item_defs);
+    auto const helmet = generate_item(item_id1, istore, item_defs);
+
+    auto& w = istore[sword].data.weapon;
+    w.dmg_min  = 2;
+    w.dmg_max  = 5;
+    w.dmg_type = damage_type::slash;
+
+    auto& a = istore[helmet].data.armor;
+    a.base = 3;
+    a.resists.fill(1);
+    a.resists[static_cast<size_t>(damage_type::fire) - 1] = 2;
+
+    //unarmed
+    REQUIRE(equip.stats().dmg_type == damage_type::blunt);
+    REQUIRE(equip.stats().totals.weight == 0);
+
+    equip.equip(sword, item_defs, istore);
+    equip.equip(helmet, item_defs, istore);
+
+    auto const& stats = equip.stats();
+
+    REQUIRE(stats.dmg_min  == 2);
+    REQUIRE(stats.dmg_max  == 5);
+    REQUIRE(stats.dmg_type == damage_type::slash);
+    REQUIRE(stats.armor_against(damage_type::pierce) == 3);
+    REQUIRE(stats.armor_against(damage_type::fire)   == 6);
+
+    //the sword takes up both hands, but is only counted once
+    REQUIRE(stats.totals.weight == 20);
+    REQUIRE(stats.totals.count(item_type::weapon) == 1);
+    REQUIRE(stats.totals.count(item_type::armor)  == 1);
+
+    equip.unequip(sword, item_defs, istore);
+
+    REQUIRE(equip.stats().dmg_type == damage_type::blunt);
+    REQUIRE(equip.stats().totals.weight == 10);
+    REQUIRE(equip.stats().totals.count(item_type::weapon) == 0);
+    REQUIRE(equip.stats().armor_against(damage_type::pierce) == 3);
+}
+
+TEST_CASE("item_collection small buffer", "[item]") {
+    using bkrl::item_collection;
+    using bkrl::item_id;
+
+    item_collection items;
+
+    auto const n = static_cast<uint32_t>(item_collection::inline_capacity);
+
+    for (uint32_t i = 0; i < n; ++i) {
+        items.insert(item_id {i});
+    }
+
+    REQUIRE(items.size() == static_cast<int>(n));
+    REQUIRE(items.is_inline());
+
+    //copies of small collections don't allocate either
+    auto const copy = items;
+    REQUIRE(copy.is_inline());
+
+    items.insert(item_id {n});
+    REQUIRE(!items.is_inline());
+
+    REQUIRE(items.remove(item_id {0}));
+    REQUIRE(items.size() == static_cast<int>(n));
+
+    auto sum = uint32_t {0};
+    items.for_each_item([&](item_id const itm) { sum += id_to_value(itm); });
+    REQUIRE(sum == (n * (n + 1)) / 2);
+}
+
+TEST_CASE("item_collection bulk operations", "[item]") {
+    using bkrl::item_collection;
+    using bkrl::item_map;
+    using bkrl::item_id;
+    using bkrl::ipoint2;
+
+    item_collection items;
+
+    //kept sorted regardless of the order of insertion
+    items.insert(item_id {7});
+    items.insert(item_id {3});
+    items.insert(item_id {5});
+
+    REQUIRE(items.contains(item_id {5}));
+    REQUIRE(!items.contains(item_id {4}));
+    REQUIRE(!items.remove(item_id {4}));
+
+    item_collection more;
+    more.insert(item_id {6});
+    more.insert(item_id {1});
+
+    items.insert_all(more);
+
+    std::vector<item_id> ids {items.data(), items.data() + items.size()};
+    REQUIRE(std::is_sorted(std::begin(ids), std::end(ids)));
+    REQUIRE(ids.size() == 5);
+
+    //to a tile and back again
+    item_map map;
+    auto const p = ipoint2 {4, 4};
+
+    map.insert_at(ipoint2 {0, 0}, item_id {100});
+    map.insert_at(p, items);
+
+    REQUIRE(items.empty());
+    REQUIRE(map.count_items_at(p) == 5);
+
+    REQUIRE(map.remove_items_at(p, items) == 5);
+    REQUIRE(map.count_items_at(p) == 0);
+    REQUIRE(map.count_items_at(ipoint2 {0, 0}) == 1);
+    REQUIRE(items.size() == 5);
+    REQUIRE(items.contains(item_id {6}));
+
+    REQUIRE(map.remove_items_at(p, items) == 0);
+}
+
+TEST_CASE("group_items", "[item]") {
+    using namespace bkrl;
+
+    auto item_defs = make_defs();
+    auto istore    = item_store {};
+
+    item_collection items;
+
+    auto const add = [&](item_def_id const id, int16_t const dmg) {
+        auto const itm = generate_item(id, istore, item_defs);
+        if (istore[itm].type == item_type::weapon) {
+            istore[itm].data.weapon.dmg_max = dmg;
+        }
+
+        items.insert(itm);
+        return itm;
+    };
+
+    add(item_id2, 0);
+    add(item_id0, 3);
+    add(item_id2, 0);
+    add(item_id0, 4); //differs from the other weapon; doesn't stack
+    add(item_id2, 0);
+
+    std::vector<item_group> groups;
+    group_items(items, istore, groups);
+
+    REQUIRE(groups.size() == 3);
+
+    //by definition
+    REQUIRE(istore[groups[0].id].def_index == item_defs.index_of(item_id0));
+    REQUIRE(istore[groups[1].id].def_index == item_defs.index_of(item_id0));
+    REQUIRE(istore[groups[2].id].def_index == item_defs.index_of(item_id2));
+
+    REQUIRE(groups[0].count == 1);
+    REQUIRE(groups[1].count == 1);
+    REQUIRE(groups[2].count == 3);
+}
+
+TEST_CASE("item_collection totals", "[item]") {
+    using namespace bkrl;
+
+    auto item_defs = make_defs();
+    auto istore    = item_store {};
+
+    item_collection items;
+
+    auto const sword  = generate_item(item_id0, istore, item_defs);
+    auto const helmet = generate_item(item_id1, istore, item_defs);
+    auto const potion = generate_item(item_id2, istore, item_defs);
+
+    items.insert(sword, istore, item_defs);
+    items.insert(potion, istore, item_defs);
+
+    REQUIRE(items.totals().weight == 20);
+    REQUIRE(items.totals().count() == 2);
+    REQUIRE(items.totals().count(item_type::weapon) == 1);
+    REQUIRE(items.totals().count(item_type::potion) == 1);
+
+    //not in the collection; nothing changes
+    REQUIRE(!items.remove(helmet, istore, item_defs));
+    REQUIRE(items.totals().weight == 20);
+
+    REQUIRE(items.remove(sword, istore, item_defs));
+    REQUIRE(items.totals().weight == 10);
+    REQUIRE(items.totals().count(item_type::weapon) == 0);
+
+    //to a tile and back again
+    item_map map;
+    auto const p = ipoint2 {2, 2};
+
+    map.insert_at(p, sword);
+    map.insert_at(p, helmet);
+
+    REQUIRE(map.remove_items_at(p, items, istore, item_defs) == 2);
+    REQUIRE(items.totals().weight == 30);
+    REQUIRE(items.totals().count() == 3);
+    REQUIRE(items.totals().count(item_type::armor) == 1);
+
+    map.insert_at(p, items);
+    REQUIRE(items.empty());
+    REQUIRE(items.totals().weight == 0);
+    REQUIRE(items.totals().count() == 0);
+}
+
+TEST_CASE("item_collection tracked and untracked", "[item]") {
+    using namespace bkrl;
+
+    struct assert_failed {};
+
+    auto const old = set_assert_handler([](assert_info const&) { throw assert_failed {}; });
+
+    auto item_defs = make_defs();
+    auto istore    = item_store {};
+
+    auto const sword  = generate_item(item_id0, istore, item_defs);
+    auto const potion = generate_item(item_id2, istore, item_defs);
+
+    item_collection items;
+    items.insert(sword, istore, item_defs);
+
+    //an untracked operation on a tracked collection would skip the totals
+    REQUIRE_THROWS_AS(items.insert(potion), assert_failed);
+    REQUIRE_THROWS_AS(items.remove(sword), assert_failed);
+    REQUIRE(items.totals().weight == 10);
+
+    //and a tracked one on a non-empty untracked collection would miss some
+    item_collection ids;
+    ids.insert(sword);
+
+    REQUIRE_THROWS_AS(ids.insert(potion, istore, item_defs), assert_failed);
+
+    //clear resets it either way
+    items.clear();
+    items.insert(potion);
+    REQUIRE(items.contains(potion));
+
+    set_assert_handler(old);
+}
+
+TEST_CASE("item_collection totals for large collections", "[item]") {
+    using namespace bkrl;
+
+    auto item_defs = make_defs();
+    auto istore    = item_store {};
+
+    //more items, and more weight, than fit in an int16_t
+    constexpr auto n = 40000;
+
+    std::vector<item_id> ids;
+    ids.reserve(n);
+    for (int i = 0; i < n; ++i) {
+        ids.push_back(generate_item(item_id0, istore, item_defs));
+    }
+
+    item_collection items;
+    items.insert_all(ids, istore, item_defs);
+
+    auto const weight = items.totals().weight;
+    REQUIRE(weight == n * 10);
+    REQUIRE(items.totals().count(item_type::weapon) == n);
+
+    REQUIRE(items.remove(ids.back(), istore, item_defs));
+    REQUIRE(items.totals().weight == (n - 1) * 10);
+    REQUIRE(items.totals().count() == n - 1);
+}
+
+TEST_CASE("item_map insertion", "[item]") {
+    using bkrl::item_map;
+    using bkrl::item_id;
+    using bkrl::ipoint2;
+
+    item_map map;
+
+    auto const p0 = ipoint2 {1, 1};
+    auto const p1 = ipoint2 {0, 2};
+    auto const p2 = ipoint2 {5, 0};
+
+    map.insert_at(p0, item_id {0});
+    map.insert_at(p1, item_id {1});
+    map.insert_at(p0, item_id {2});
+
+    map.insert_batch([&](auto&& insert) {
+        insert(p2, item_id {3});
+        insert(p0, item_id {4});
+        insert(p1, item_id {5});
+        insert(p0, item_id {6});
+    });
+
+    REQUIRE(map.count_items_at(p0) == 4);
+    REQUIRE(map.count_items_at(p1) == 2);
+    REQUIRE(map.count_items_at(p2) == 1);
+    REQUIRE(map.count_items_at(ipoint2 {9, 9}) == 0);
+
+    //items in a stack keep the order they were inserted in
+    std::vector<uint32_t> ids;
+    map.for_each_item_at(p0, [&](item_id const itm) {
+        ids.push_back(id_to_value(itm));
+    });
+
+    REQUIRE((ids == std::vector<uint32_t> {0, 2, 4, 6}));
+
+    //and the stacks as a whole are in order
+    std::vector<ipoint2> stacks;
+    map.for_each_stack([&](ipoint2 const p, item_id, int) {
+        stacks.push_back(p);
+    });
+
+    REQUIRE(stacks.size() == 3);
+    REQUIRE(std::is_sorted(std::begin(stacks), std::end(stacks), item_map::record_t::less));
+
+    REQUIRE(map.remove_item_at(p0, item_id {4}));
+    REQUIRE(!map.remove_item_at(p0, item_id {3}));
+    REQUIRE(map.count_items_at(p0) == 3);
+    REQUIRE(map.count_items_at(p2) == 1);
+}
+
+TEST_CASE("item_store removal and recycling", "[item]") {
+    bkrl::item_store store;
+
+    auto origin = bkrl::item_birthplace {};
+    origin.type = bkrl::item_birthplace::entity;
+    origin.id   = 42;
+
+    auto const id0 = store.insert(make_item(0));
+    auto const id1 = store.insert(make_item(1));
+    auto const id2 = store.insert(make_item(2), origin);
+
+    REQUIRE(store.size() == 3);
+    REQUIRE(store.contains(id0));
+    REQUIRE(store[id1].def_index == bkrl::item_def_index {1});
+
+    //removing from the middle leaves the others where they can be found
+    store.remove(id1);
+
+    REQUIRE(store.size() == 2);
+    REQUIRE(!store.contains(id1));
+    REQUIRE(store[id0].def_index == bkrl::item_def_index {0});
+    REQUIRE(store[id2].def_index == bkrl::item_def_index {2});
+
+    //the origin follows its item around
+    REQUIRE(store.origin(id2).type == bkrl::item_birthplace::entity);
+    REQUIRE(store.origin(id2).id   == 42);
+    REQUIRE(store.origin(id0).type == bkrl::item_birthplace::floor);
+
+    //the slot is reused, but not the id
+    auto const id3 = store.insert(make_item(1));
+
+    REQUIRE(id3 != id1);
+    REQUIRE(!store.contains(id1));
+    REQUIRE(store.contains(id3));
+    REQUIRE(store[id3].def_index == bkrl::item_def_index {1});
+
+    store.remove(id0);
+    store.remove(id2);
+    store.remove(id3);
+
+    REQUIRE(store.size() == 0);
+    REQUIRE(!store.contains(id0));
+    REQUIRE(!store.contains(bkrl::item_id {0}));
+}
+
+TEST_CASE("item_store arenas", "[item]") {
+    using bkrl::item_arena;
+
+    bkrl::item_store store;
+
+    auto const global = store.insert(make_item(0));
+
+    auto level = bkrl::unique_item_arena {store};
+    auto const arena = level.get();
+
+    REQUIRE(arena != item_arena {});
+
+    auto const id0 = store.insert(make_item(1), bkrl::item_birthplace {}, arena);
+    auto const id1 = store.insert(make_item(2), bkrl::item_birthplace {}, arena);
+
+    REQUIRE(store.size() == 3);
+    REQUIRE(store.size(item_arena {}) == 1);
+    REQUIRE(store.size(arena) == 2);
+    REQUIRE(store.arena_of(global) == item_arena {});
+    REQUIRE(store.arena_of(id0) == arena);
+
+    //the arena's items are contiguous
+    auto sum = 0;
+    store.for_each_item(arena, [&](bkrl::item const& itm) {
+        sum += id_to_value(itm.def_index);
+    });
+    REQUIRE(sum == 3);
+
+    //moving an item between arenas gives it a new id
+    auto const moved = store.move_to(id0, item_arena {});
+
+    REQUIRE(moved != id0);
+    REQUIRE(!store.contains(id0));
+    REQUIRE(store.arena_of(moved) == item_arena {});
+    REQUIRE(store[moved].def_index == bkrl::item_def_index {1});
+    REQUIRE(store.move_to(moved, item_arena {}) == moved);
+    REQUIRE(store.size(arena) == 1);
+
+    //releasing the arena frees everything left in it, and nothing else
+    level.reset();
+
+    REQUIRE(!store.contains(id1));
+    REQUIRE(store.contains(global));
+    REQUIRE(store.contains(moved));
+    REQUIRE(store.size() == 2);
+
+    //a recycled arena doesn't bring old ids back to life
+    auto again = bkrl::unique_item_arena {store};
+    auto const id2 = store.insert(make_item(2), bkrl::item_birthplace {}, again.get());
+
+    REQUIRE(again.get() == arena);
+    REQUIRE(id2 != id1);
+    REQUIRE(!store.contains(id1));
+    REQUIRE(store.contains(id2));
+}
+
+TEST_CASE("item_store container contents", "[item]") {
+    using bkrl::item_arena;
+
+    bkrl::item_store store;
+    auto level = bkrl::unique_item_arena {store};
+
+    auto bag = make_item(0);
+    bag.type = bkrl::item_type::container;
+
+    auto const box   = store.insert(make_item(0), bkrl::item_birthplace {}, level.get());
+    auto const inner = store.insert(make_item(1));
+    auto       id    = store.insert(std::move(bag), bkrl::item_birthplace {}, level.get());
+
+    auto const& cstore = store;
+    REQUIRE(cstore.contents(id).empty());
+
+    store.contents(id).insert(inner);
+
+    //moving other items around the arena leaves the contents alone
+    store.remove(box);
+    REQUIRE(store[id].type == bkrl::item_type::container);
+    REQUIRE(cstore.contents(id).size() == 1);
+
+    //the contents follow the container to another arena
+    id = store.move_to(id, item_arena {});
+    REQUIRE(cstore.contents(id).size() == 1);
+    REQUIRE(*cstore.contents(id).begin() == inner);
+
+    //and are dropped with it; a new container starts out empty
+    store.remove(id);
+
+    auto bag2 = make_item(0);
+    bag2.type = bkrl::item_type::container;
+
+    auto const id2 = store.insert(std::move(bag2));
+    REQUIRE(cstore.contents(id2).empty());
+    REQUIRE(store.contains(inner));
+}
+
+TEST_CASE("item_store arena limits", "[item]") {
+    bkrl::item_store store;
+
+    //far more arenas than there will ever be levels can be in use at once,
+    //and each keeps its own items
+    constexpr auto arena_count = 1000;
+    static_assert(arena_count < bkrl::item_store::max_arenas, "");
+
+    std::vector<bkrl::unique_item_arena> arenas;
+    std::vector<bkrl::item_id>           ids;
+
+    for (int i = 0; i < arena_count; ++i) {
+        arenas.emplace_back(store);
+        ids.push_back(store.insert(make_item(1), bkrl::item_birthplace {}, arenas.back().get()));
+    }
+
+    for (size_t i = 0; i < arenas.size(); ++i) {
+        REQUIRE(store.arena_of(ids[i]) == arenas[i].get());
+        REQUIRE(store.size(arenas[i].get()) == 1);
+    }
+
+    REQUIRE(store.size(bkrl::item_arena {}) == 0);
+
+    //and a single arena holds millions of items
+    constexpr auto item_count = size_t {1} << 21;
+    static_assert(item_count < bkrl::item_store::max_arena_items, "");
+
+    auto const& last = arenas.back();
+    for (size_t i = 1; i < item_count; ++i) {
+        store.insert(make_item(1), bkrl::item_birthplace {}, last.get());
+    }
+
+    REQUIRE(store.size(last.get()) == item_count);
+    REQUIRE(store.contains(ids.back()));
+}
+
+//------------------------------------------------------------------------------
+//! Compare lookups in the item_store against the hash map it replaced, for
+//! 100k live items and with some churn.
+//------------------------------------------------------------------------------
+TEST_CASE("item_store benchmark", "[.][benchmark][item]") {
+    constexpr auto item_count = 100000;
+    constexpr auto lookups    = 10000000;
+
+    struct hash_t {
+        size_t operator()(bkrl::item_id const id) const noexcept {
+            return std::hash<bkrl::item_id::value_type> {}(id_to_value(id));
+        }
+    };
+
+    bkrl::random::generator gen {1234};
+
+    std::vector<bkrl::item_id> ids;
+    ids.reserve(item_count);
+
+    //
+    // hash map
+    //
+    {
+        std::unordered_map<bkrl::item_id, bkrl::item, hash_t> map;
+        for (uint32_t i = 0; i < item_count; ++i) {
+            auto const id = bkrl::item_id {0x80000000 | i};
+            map.emplace(id, make_item(1));
+            ids.push_back(id);
+        }
+
+        auto sink = uint32_t {0};
+        bkrl::stopwatch watch;
+        for (int i = 0; i < lookups; ++i) {
+            auto const id = ids[bkrl::random::uniform_range(gen, 0, item_count - 1)];
+            sink += id_to_value(map.find(id)->second.def_index);
+        }
+        watch.report("hash map:  ");
+
+        REQUIRE(sink != 0);
+    }
+
+    ids.clear();
+
+    //
+    // item_store, after removing and replacing a quarter of the items
+    //
+    {
+        bkrl::item_store store;
+        for (int i = 0; i < item_count; ++i) {
+            ids.push_back(store.insert(make_item(1)));
+        }
+
+        for (int i = 0; i < item_count; i += 4) {
+            store.remove(ids[i]);
+            ids[i] = store.insert(make_item(1));
+        }
+
+        REQUIRE(store.size() == item_count);
+
+        auto sink = uint32_t {0};
+        bkrl::stopwatch watch;
+        for (int i = 0; i < lookups; ++i) {
+            auto const id = ids[bkrl::random::uniform_range(gen, 0, item_count - 1)];
+            sink += id_to_value(store[id].def_index);
+        }
+        watch.report("item_store: ");
+
+        REQUIRE(sink != 0);
+    }
+}
+
+//------------------------------------------------------------------------------
+//! The size of an item, and the time taken to visit every item in a store of
+//! 1M items, both by id and in storage order.
+//------------------------------------------------------------------------------
+TEST_CASE("item_store iteration benchmark", "[.][benchmark][item]") {
+    constexpr auto item_count = 1000000;
+    constexpr auto repeat     = 10;
+
+    WARN("sizeof(item): " << sizeof(bkrl::item) << " bytes");
+
+    bkrl::item_store store;
+
+    std::vector<bkrl::item_id> ids;
+    ids.reserve(item_count);
+
+    for (int i = 0; i < item_count; ++i) {
+        auto itm = make_item(i % 3);
+        itm.type = bkrl::item_type::weapon;
+        itm.data.weapon.dmg_max = static_cast<int16_t>(i & 7);
+
+        ids.push_back(store.insert(std::move(itm)));
+    }
+
+    auto const visit = [](bkrl::item const& itm) {
+        return static_cast<uint64_t>(itm.data.weapon.dmg_max + id_to_value(itm.def_index));
+    };
+
+    auto sink_ids = uint64_t {0};
+    {
+        bkrl::stopwatch watch;
+        for (int r = 0; r < repeat; ++r) {
+            for (auto const id : ids) {
+                sink_ids += visit(store[id]);
+            }
+        }
+        watch.report("by id:         ", repeat);
+    }
+
+    auto sink_dense = uint64_t {0};
+    {
+        bkrl::stopwatch watch;
+        for (int r = 0; r < repeat; ++r) {
+            store.for_each_item([&](bkrl::item const& itm) {
+                sink_dense += visit(itm);
+            });
+        }
+        watch.report("storage order: ", repeat);
+    }
+
+    REQUIRE(sink_ids == sink_dense);
+}
+
+TEST_CASE("item_stack_summary", "[item]") {
+    using bkrl::ipoint2;
+    using stack_t = bkrl::item_stack_summary::stack_t;
+
+    auto const defs = make_defs();
+
+    bkrl::item_store         store;
+    bkrl::item_map           map;
+    bkrl::item_stack_summary summary {10, 10};
+
+    auto const p0 = ipoint2 {3, 4};
+    auto const p1 = ipoint2 {1, 7};
+
+    auto const insert = [&](ipoint2 const p, bkrl::item_def_id const id) {
+        auto const itm = bkrl::generate_item(id, store, defs);
+        map.insert_at(p, itm);
+        summary.update(p, map, store, defs);
+        return itm;
+    };
+
+    auto const stacks = [&] {
+        std::vector<stack_t> result;
+        summary.for_each_stack([&](stack_t const& s) { result.push_back(s); });
+        return result;
+    };
+
+    REQUIRE(summary.count_at(p0) == 0);
+    REQUIRE(stacks().empty());
+
+    auto const itm0 = insert(p0, item_id0);
+
+    REQUIRE(summary.count_at(p0) == 1);
+    REQUIRE(stacks().size() == 1);
+    REQUIRE(stacks()[0].info.tex_position == store[itm0].render_info(defs).tex_position);
+
+    insert(p0, item_id1);
+    auto const itm2 = insert(p1, item_id2);
+
+    REQUIRE(summary.count_at(p0) == 2);
+    REQUIRE(summary.count_at(p1) == 1);
+
+    auto const s = stacks();
+    REQUIRE(s.size() == 2);
+    REQUIRE(bkrl::item_map::record_t::less(s[0].pos, s[1].pos));
+
+    auto const& pile = (s[0].pos == p0) ? s[0] : s[1];
+    REQUIRE(pile.count == 2);
+    REQUIRE(pile.info.tex_position == defs.get_stack_info(2).tex_position);
+
+    REQUIRE(map.remove_item_at(p1, itm2));
+    summary.update(p1, map, store, defs);
+
+    REQUIRE(summary.count_at(p1) == 0);
+    REQUIRE(stacks().size() == 1);
+}
+
+TEST_CASE("item_id_view", "[item]") {
+    using bkrl::item_map;
+    using bkrl::item_id;
+    using bkrl::item_id_view;
+    using bkrl::ipoint2;
+
+    item_map map;
+
+    auto const p0 = ipoint2 {2, 2};
+    auto const p1 = ipoint2 {3, 2};
+
+    map.insert_batch([&](auto&& insert) {
+        insert(p0, item_id {10});
+        insert(p1, item_id {20});
+        insert(p0, item_id {11});
+        insert(p1, item_id {21});
+        insert(p0, item_id {12});
+    });
+
+    auto const v0 = map.items_at(p0);
+    auto const v1 = map.items_at(p1);
+
+    REQUIRE(v0.size() == 3);
+    REQUIRE(v1.size() == 2);
+    REQUIRE(map.items_at(ipoint2 {0, 0}).empty());
+
+    REQUIRE(v0[0] == item_id {10});
+    REQUIRE(v0[2] == item_id {12});
+
+    std::vector<item_id> ids {std::begin(v1), std::end(v1)};
+    REQUIRE((ids == std::vector<item_id> {item_id {20}, item_id {21}}));
+
+    //collections convert to views of themselves
+    bkrl::item_collection items;
+    items.insert(item_id {1});
+    items.insert(item_id {2});
+
+    item_id_view const v2 = items;
+    REQUIRE(v2.size() == 2);
+    REQUIRE(v2[1] == item_id {2});
+}
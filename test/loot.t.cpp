@@ -8,8 +8,12 @@
 #include "items.hpp"
 #include "json.hpp"
 #include "random.hpp"
+#include "benchmark.hpp"
 
 #include <map>
+#include <algorithm>
+#include <cmath>
+#include <string>
 
 ////////////////////////////////////////////////////////////////////////////////
 // tests
@@ -80,7 +84,7 @@ struct test_data {
 
 //==============================================================================
 TEST_CASE("Check a roll_all table with a single percentage entry", "[loot_table]") {
-    constexpr auto iterations = 1000;
+    constexpr auto iterations = 10000;
 
     char const table[] = R"(
     { "type": "roll_all"
@@ -233,6 +237,135 @@ TEST_CASE("Check a choose_one table with unevenly weighted entries", "[loot_tabl
     REQUIRE(result1.check_with_tolerance(expected1, 0.1));
 }
 
+//==============================================================================
+TEST_CASE("Check a choose_one table with many weighted entries", "[loot_table]") {
+    constexpr auto iterations = 100000;
+
+    char const table[] = R"(
+    { "type": "choose_one"
+    , "rules": [
+        [1,  "TEST0"]
+      , [2,  "TEST1"]
+      , [3,  "TEST2"]
+      , [5,  "TEST3"]
+      , [8,  "TEST4"]
+      , [13, "TEST5"]
+      , [21, "TEST6"]
+      , [40, "TEST7"]
+      ]
+    }
+    )";
+
+    std::pair<char const*, int> const weights[] = {
+        {"TEST0", 1}, {"TEST1", 2}, {"TEST2", 3}, {"TEST3", 5}
+      , {"TEST4", 8}, {"TEST5", 13}, {"TEST6", 21}, {"TEST7", 40}
+    };
+
+    auto const sum = 93.0;
+
+    test_data test;
+    auto const test_table = test.make_table(table);
+    test.roll(test_table, iterations);
+
+    REQUIRE(test.results.size() == 8);
+
+    auto total = 0;
+    for (auto const& w : weights) {
+        auto const& result = test.results[bkrl::slash_hash32(w.first)];
+
+        total += result.count;
+
+        REQUIRE(result.check_min_max(1, 1));
+        REQUIRE(result.check_with_tolerance(iterations * (w.second / sum), 0.1));
+    }
+
+    REQUIRE(total == iterations);
+}
+
+//==============================================================================
+TEST_CASE("alias_table chooses each index in proportion to its weight", "[loot_table]") {
+    using bkrl::random::alias_table;
+
+    auto const check = [](std::vector<uint16_t> const& weights) {
+        alias_table const table {weights};
+
+        auto const n = static_cast<uint32_t>(weights.size());
+
+        REQUIRE(table.size() == n);
+        REQUIRE(table.roll_count() == n * table.total());
+
+        //every possible roll; exactly weight * n of them map to each index
+        std::vector<uint32_t> counts(n);
+        for (uint32_t roll = 0; roll < table.roll_count(); ++roll) {
+            ++counts[table.choose(roll)];
+        }
+
+        for (uint32_t i = 0; i < n; ++i) {
+            REQUIRE(counts[i] == weights[i] * n);
+        }
+    };
+
+    check({1});
+    check({1, 1});
+    check({2, 10});
+    check({1, 2, 3, 5, 8, 13, 21, 40});
+    check({0, 7, 0, 1});
+    check({1000, 1, 1, 1, 1, 1, 1});
+}
+
+//------------------------------------------------------------------------------
+//! Compare choosing from a large choose_one table with a linear scan of the
+//! cumulative weights against the alias table.
+//------------------------------------------------------------------------------
+TEST_CASE("alias_table benchmark", "[.][benchmark][loot_table]") {
+    constexpr auto entries = 256;
+    constexpr auto draws   = 1000000;
+
+    std::vector<uint16_t> weights(entries);
+    std::vector<uint16_t> sums(entries);
+
+    auto sum = uint16_t {0};
+    for (int i = 0; i < entries; ++i) {
+        weights[i] = static_cast<uint16_t>(1 + i % 7);
+        sum += weights[i];
+        sums[i] = sum;
+    }
+
+    bkrl::random::alias_table const table {weights};
+
+    auto sink_scan = uint64_t {0};
+    {
+        bkrl::random_t gen {1234};
+
+        bkrl::stopwatch watch;
+        for (int i = 0; i < draws; ++i) {
+            auto const roll = bkrl::random::uniform_range<uint16_t>(gen, 0, sum - 1);
+            auto const it   = std::find_if(std::begin(sums), std::end(sums)
+              , [&](uint16_t const s) { return roll < s; });
+
+            sink_scan += static_cast<uint64_t>(std::distance(std::begin(sums), it));
+        }
+        watch.report("linear scan: ");
+    }
+
+    auto sink_alias = uint64_t {0};
+    {
+        bkrl::random_t gen {1234};
+
+        bkrl::stopwatch watch;
+        for (int i = 0; i < draws; ++i) {
+            sink_alias += table(gen);
+        }
+        watch.report("alias table: ");
+    }
+
+    //different draws, same distribution; the means agree closely
+    auto const mean_scan  = static_cast<double>(sink_scan)  / draws;
+    auto const mean_alias = static_cast<double>(sink_alias) / draws;
+
+    REQUIRE(std::abs(mean_scan - mean_alias) < 1.0);
+}
+
 //==============================================================================
 TEST_CASE("Simple check loot_table_definitions", "[loot_table]") {
     char const table_defs[] = R"(
@@ -266,6 +399,346 @@ TEST_CASE("Simple check loot_table_definitions", "[loot_table]") {
     REQUIRE(t2.type() == bkrl::loot_table::roll_t::roll_all);
 }
 
+//==============================================================================
+TEST_CASE("Check linked nested loot_table_definitions", "[loot_table]") {
+    constexpr auto iterations = 1000;
+
+    char const table_defs[] = R"(
+    { "file_type": "LOOT"
+    , "definitions": [
+        { "id": "ROOT"
+        , "rules": [[100, "WEAPON", 2, "table"], [100, "COIN", 1, "table"]]
+        }
+      , { "id": "WEAPON"
+        , "type": "choose_one"
+        , "rules": [[1, "SWORD"], [1, "AXE"]]
+        }
+      , { "id": "COIN"
+        , "type": "choose_one"
+        , "rules": [[1, "GOLD", 1, "table"]]
+        }
+      , { "id": "GOLD"
+        , "rules": [[100, "GOLD_COIN", [1, 3]]]
+        }
+      ]
+    }
+    )";
+
+    test_data test;
+    test.defs.load_definitions(bkrl::json::common::from_memory(table_defs));
+
+    REQUIRE(!test.defs.find_cycle());
+    test.defs.link();
+
+    auto const& root = test.defs[bkrl::loot_table_def_id {bkrl::slash_hash32("ROOT")}];
+    REQUIRE(root.is_linked());
+
+    //COIN -> GOLD -> GOLD_COIN always yields GOLD_COIN and is flattened.
+    auto const& coin = test.defs[bkrl::loot_table_def_id {bkrl::slash_hash32("COIN")}];
+    REQUIRE(coin.only_rule() != nullptr);
+    REQUIRE(coin.only_rule()->id_type == bkrl::loot_rule_data_t::id_t::item_ref);
+    REQUIRE(coin.only_rule()->id == bkrl::slash_hash32("GOLD_COIN"));
+
+    test.roll(root, iterations);
+
+    auto& sword = test.results[bkrl::slash_hash32("SWORD")];
+    auto& axe   = test.results[bkrl::slash_hash32("AXE")];
+    auto& gold  = test.results[bkrl::slash_hash32("GOLD_COIN")];
+
+    REQUIRE(test.results.size() == 3);
+    auto const weapons = sword.count + axe.count;
+    REQUIRE(weapons == iterations * 2);
+    REQUIRE(sword.check_with_tolerance(iterations, 0.1));
+    REQUIRE(gold.count == iterations);
+    REQUIRE(gold.check_min_max(1, 3));
+}
+
+//==============================================================================
+TEST_CASE("Check loot_table_definitions with a cycle", "[loot_table]") {
+    char const table_defs[] = R"(
+    { "file_type": "LOOT"
+    , "definitions": [
+        { "id": "A"
+        , "rules": [[50, "B", 1, "table"], [50, "ITEM"]]
+        }
+      , { "id": "B"
+        , "type": "choose_one"
+        , "rules": [[1, "C", 1, "table"], [1, "ITEM"]]
+        }
+      , { "id": "C"
+        , "type": "choose_one"
+        , "rules": [[1, "A", 1, "table"], [1, "ITEM"]]
+        }
+      , { "id": "D"
+        , "rules": [[50, "A", 1, "table"]]
+        }
+      ]
+    }
+    )";
+
+    bkrl::loot_table_definitions defs;
+    defs.load_definitions(bkrl::json::common::from_memory(table_defs));
+
+    auto const cycle = defs.find_cycle();
+    REQUIRE(!!cycle);
+
+    auto const id = bkrl::id_to_value(*cycle);
+    REQUIRE((id == bkrl::slash_hash32("A")
+          || id == bkrl::slash_hash32("B")
+          || id == bkrl::slash_hash32("C")));
+}
+
+namespace {
+char const batch_table_defs[] = R"(
+{ "file_type": "LOOT"
+, "definitions": [
+    { "id": "ROOT"
+    , "rules": [[50, "WEAPON", [1, 2], "table"], [30, "ITEM0", [1, 5]], [[1, 3], "ITEM1"]]
+    }
+  , { "id": "WEAPON"
+    , "type": "choose_one"
+    , "rules": [[1, "SWORD"], [3, "AXE"], [2, "DAGGER"]]
+    }
+  ]
+}
+)";
+} //namespace
+
+//==============================================================================
+TEST_CASE("Check generate_n against repeated generate", "[loot_table]") {
+    constexpr auto rolls = 500;
+
+    bkrl::loot_table_definitions defs;
+    defs.load_definitions(bkrl::json::common::from_memory(batch_table_defs));
+    defs.link();
+
+    auto const& root = defs[bkrl::loot_table_def_id {bkrl::slash_hash32("ROOT")}];
+
+    std::vector<std::vector<bkrl::loot_result_t>> expected(rolls);
+    {
+        bkrl::random_t gen {42};
+        for (auto& results : expected) {
+            root.generate(gen, defs, [&](bkrl::item_def_id const id, uint16_t const n) {
+                results.push_back(bkrl::loot_result_t {id, n});
+            });
+        }
+    }
+
+    bkrl::loot_batch batch;
+
+    auto const check = [&] {
+        REQUIRE(batch.size() == rolls);
+
+        for (size_t i = 0; i < rolls; ++i) {
+            auto const& results = expected[i];
+
+            auto const first = batch.roll_begin(i);
+            auto const last  = batch.roll_end(i);
+
+            REQUIRE(static_cast<size_t>(last - first) == results.size());
+
+            for (size_t j = 0; j < results.size(); ++j) {
+                REQUIRE(first[j].id    == results[j].id);
+                REQUIRE(first[j].count == results[j].count);
+            }
+        }
+    };
+
+    bkrl::random_t gen {42};
+    root.generate_n(gen, defs, rolls, batch);
+    check();
+
+    //the same batch is reused without growing, or moving.
+    auto const roll_capacity   = batch.roll_capacity();
+    auto const result_capacity = batch.result_capacity();
+    auto const results         = &*batch.begin();
+
+    batch.clear();
+    REQUIRE(batch.empty());
+    REQUIRE(batch.roll_capacity()   == roll_capacity);
+    REQUIRE(batch.result_capacity() == result_capacity);
+
+    gen.seed(42);
+    root.generate_n(gen, defs, rolls, batch);
+    check();
+
+    REQUIRE(batch.roll_capacity()   == roll_capacity);
+    REQUIRE(batch.result_capacity() == result_capacity);
+    REQUIRE(&*batch.begin() == results);
+
+    //and a batch that is big enough never allocates, even for fewer rolls.
+    for (int i = 0; i < 100; ++i) {
+        batch.clear();
+        root.generate_n(gen, defs, 1, batch);
+
+        REQUIRE(batch.size() == 1);
+        REQUIRE(batch.result_capacity() == result_capacity);
+    }
+}
+
+//==============================================================================
+TEST_CASE("Check exact expected counts", "[loot_table]") {
+    constexpr auto rolls = 200000;
+
+    bkrl::loot_table_definitions defs;
+    defs.load_definitions(bkrl::json::common::from_memory(batch_table_defs));
+    defs.link();
+
+    auto const& root = defs[bkrl::loot_table_def_id {bkrl::slash_hash32("ROOT")}];
+
+    auto const expected = root.expected_counts(defs);
+    REQUIRE(expected.size() == 5);
+
+    auto const exact = [&](char const* const id) {
+        auto const hash = bkrl::slash_hash32(id);
+        auto const it = std::find_if(std::begin(expected), std::end(expected)
+          , [&](bkrl::loot_expectation_t const& e) { return bkrl::id_to_value(e.id) == hash; });
+
+        REQUIRE(it != std::end(expected));
+        return it->count;
+    };
+
+    //50% of [1, 2] WEAPON tables, each 1 in 6 SWORD, 3 in 6 AXE, 2 in 6 DAGGER
+    REQUIRE(exact("SWORD")  == Approx(0.5 * 1.5 * (1.0 / 6.0)));
+    REQUIRE(exact("AXE")    == Approx(0.5 * 1.5 * (3.0 / 6.0)));
+    REQUIRE(exact("DAGGER") == Approx(0.5 * 1.5 * (2.0 / 6.0)));
+    REQUIRE(exact("ITEM0")  == Approx(0.3 * 3.0));
+    REQUIRE(exact("ITEM1")  == Approx(1.0 / 3.0));
+
+    //and sampling agrees
+    bkrl::random_t gen {314};
+    bkrl::loot_batch batch;
+    root.generate_n(gen, defs, rolls, batch);
+
+    for (auto const& e : expected) {
+        auto total = 0.0;
+        for (auto const& result : batch) {
+            if (result.id == e.id) {
+                total += result.count;
+            }
+        }
+
+        auto const mean = total / rolls;
+        REQUIRE(mean == Approx(e.count).epsilon(0.02));
+    }
+}
+
+//==============================================================================
+//! Each table generates the next one twice; walking every reference would
+//! visit the last table 2^depth times.
+//==============================================================================
+TEST_CASE("Check expected counts of shared tables", "[loot_table]") {
+    constexpr auto depth = 40;
+
+    auto const name = [](int const i) {
+        return "T" + std::to_string(i);
+    };
+
+    std::string json = R"({ "file_type": "LOOT", "definitions": [)";
+    for (int i = 0; i < depth; ++i) {
+        json += R"({ "id": ")" + name(i) + R"(", "rules": [)"
+          R"([100, ")" + name(i + 1) + R"(", [1, 2], "table"], )"
+          R"([100, ")" + name(i + 1) + R"(", [1, 1], "table"]]}, )";
+    }
+    json += R"({ "id": ")" + name(depth) + R"(", "rules": [[100, "ITEM0"], [50, "ITEM1"]]}]})";
+
+    bkrl::loot_table_definitions defs;
+    defs.load_definitions(bkrl::json::common::from_memory(json));
+    defs.link();
+
+    auto const& root = defs[bkrl::loot_table_def_id {bkrl::slash_hash32("T0")}];
+
+    auto const expected = root.expected_counts(defs);
+    REQUIRE(expected.size() == 2);
+
+    //2.5 copies of the next table per level
+    auto const copies = std::pow(2.5, depth);
+    auto const item0  = bkrl::item_def_id {bkrl::slash_hash32("ITEM0")};
+
+    auto const& e0 = (expected[0].id == item0) ? expected[0] : expected[1];
+    auto const& e1 = (expected[0].id == item0) ? expected[1] : expected[0];
+
+    REQUIRE(e0.count == Approx(copies));
+    REQUIRE(e1.count == Approx(copies * 0.5));
+
+    //the cached counts are the same ones
+    auto const& cached = defs.expected_counts(defs.index_of(root.id()));
+    REQUIRE(cached.size() == expected.size());
+    REQUIRE(cached[0].count == expected[0].count);
+}
+
+//==============================================================================
+//! Compare generating through a type erased callback, an inlined sink and into
+//! a reused batch.
+//==============================================================================
+TEST_CASE("loot generation benchmark", "[.][benchmark][loot_table]") {
+    constexpr auto rolls  = 100000;
+    constexpr auto repeat = 10;
+
+    bkrl::loot_table_definitions defs;
+    defs.load_definitions(bkrl::json::common::from_memory(batch_table_defs));
+    defs.link();
+
+    auto const& root = defs[bkrl::loot_table_def_id {bkrl::slash_hash32("ROOT")}];
+
+    auto sink_function = uint64_t {0};
+    {
+        bkrl::random_t gen {1234};
+
+        //captures enough that std::function can't store it inline.
+        auto a = uint64_t {0}, b = uint64_t {0}, c = uint64_t {0};
+        auto& total = sink_function;
+
+        bkrl::stopwatch watch;
+        for (int r = 0; r < repeat; ++r) {
+            for (int i = 0; i < rolls; ++i) {
+                root.generate(gen, defs, bkrl::loot_table::write_t {
+                    [&, i](bkrl::item_def_id, uint16_t const n) {
+                        a += n; b += i; c += r; total += n;
+                    }
+                });
+            }
+        }
+        watch.report("std::function: ");
+    }
+
+    auto sink_inline = uint64_t {0};
+    {
+        bkrl::random_t gen {1234};
+
+        bkrl::stopwatch watch;
+        for (int r = 0; r < repeat; ++r) {
+            for (int i = 0; i < rolls; ++i) {
+                root.generate(gen, defs, [&](bkrl::item_def_id, uint16_t const n) {
+                    sink_inline += n;
+                });
+            }
+        }
+        watch.report("inline sink:   ");
+    }
+
+    auto sink_batch = uint64_t {0};
+    {
+        bkrl::random_t gen {1234};
+        bkrl::loot_batch batch;
+
+        bkrl::stopwatch watch;
+        for (int r = 0; r < repeat; ++r) {
+            batch.clear();
+            root.generate_n(gen, defs, rolls, batch);
+
+            for (auto const& result : batch) {
+                sink_batch += result.count;
+            }
+        }
+        watch.report("batch:         ");
+    }
+
+    //same seed, same rolls
+    REQUIRE(sink_function == sink_inline);
+    REQUIRE(sink_inline   == sink_batch);
+}
+
 //==============================================================================
 TEST_CASE("Check a string table", "[loot_table]") {
     constexpr auto iterations = 1000;
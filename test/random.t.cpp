@@ -0,0 +1,390 @@
+#include "catch/catch.hpp"
+#include "random.hpp"
+#include "benchmark.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+using mt19937_generator = bkrl::random::basic_generator<boost::mt19937>;
+using xoshiro_generator = bkrl::random::basic_generator<bkrl::random::xoshiro256ss>;
+
+TEST_CASE("xoshiro256** reference values", "[random]") {
+    bkrl::random::xoshiro256ss gen {1234};
+
+    //splitmix64 seeding followed by xoshiro256** as published
+    REQUIRE(gen() == 0x0BAB45D9A0E3AE53ull);
+    REQUIRE(gen() == 0xD7C640660C19433Eull);
+    REQUIRE(gen() == 0xB0DEDAA0D09A6691ull);
+}
+
+TEST_CASE("philox4x32 reference values", "[random]") {
+    using philox = bkrl::random::philox4x32;
+
+    //known answers from Random123
+    REQUIRE((philox::block(philox::key_t {{0, 0}}, philox::block_t {{0, 0, 0, 0}})
+        == philox::block_t {{0x6627E8D5u, 0xE169C58Du, 0xBC57AC4Cu, 0x9B00DBD8u}}));
+
+    REQUIRE((philox::block(philox::key_t {{~0u, ~0u}}, philox::block_t {{~0u, ~0u, ~0u, ~0u}})
+        == philox::block_t {{0x408F276Du, 0x41C83B0Eu, 0xA20BC7C6u, 0x6D5451FDu}}));
+
+    REQUIRE((philox::block(philox::key_t {{0xA4093822u, 0x299F31D0u}}
+                         , philox::block_t {{0x243F6A88u, 0x85A308D3u, 0x13198A2Eu, 0x03707344u}})
+        == philox::block_t {{0xD16CFE09u, 0x94FDCCEBu, 0x5001E420u, 0x24126EA1u}}));
+
+    //a stream draws the blocks for counters 0, 1, 2, ... in order
+    philox gen {0};
+    REQUIRE(gen() == 0x6627E8D5u);
+    REQUIRE(gen() == 0xE169C58Du);
+    REQUIRE(gen() == 0xBC57AC4Cu);
+    REQUIRE(gen() == 0x9B00DBD8u);
+    REQUIRE(gen.position() == 4);
+}
+
+TEST_CASE("philox4x32 streams are independent of order", "[random]") {
+    using philox = bkrl::random::philox4x32;
+
+    constexpr auto n = 100;
+
+    philox const root {1234};
+
+    auto const draw = [](philox gen) {
+        std::vector<uint32_t> result;
+        for (int i = 0; i < n; ++i) {
+            result.push_back(gen());
+        }
+        return result;
+    };
+
+    //deriving doesn't depend on what was drawn from the parent
+    auto parent = root;
+    auto const a = draw(parent.derive(7));
+    parent.discard(1000);
+    parent();
+    REQUIRE(draw(parent.derive(7)) == a);
+
+    //other keys, or keys at another level, give other streams
+    REQUIRE(draw(root.derive(8)) != a);
+    REQUIRE(draw(root.derive(7).derive(7)) != a);
+    REQUIRE(draw(philox {1235}.derive(7)) != a);
+
+    //skipping ahead lands on the same values as drawing
+    auto gen = root.derive(7);
+    gen.discard(37);
+    for (int i = 37; i < n; ++i) {
+        REQUIRE(gen() == a[i]);
+    }
+}
+
+TEST_CASE("xoshiro256** jump", "[random]") {
+    bkrl::random::xoshiro256ss gen {1234};
+    REQUIRE(gen() == 0x0BAB45D9A0E3AE53ull);
+
+    //as the reference jump()
+    gen.jump();
+    REQUIRE(gen() == 0x0CEB4AC8C6D2D148ull);
+    REQUIRE(gen() == 0x9551934B548E2670ull);
+}
+
+namespace {
+template <typename Generator>
+void check_deterministic() {
+    Generator a {42};
+    Generator b {42};
+    Generator c {43};
+
+    std::vector<int> values;
+
+    auto same_as_c = true;
+    for (int i = 0; i < 100; ++i) {
+        auto const va = bkrl::random::uniform_range(a, 0, 1000000);
+        auto const vb = bkrl::random::uniform_range(b, 0, 1000000);
+        auto const vc = bkrl::random::uniform_range(c, 0, 1000000);
+
+        REQUIRE(va == vb);
+        same_as_c = same_as_c && (va == vc);
+
+        values.push_back(va);
+    }
+
+    REQUIRE(!same_as_c);
+
+    //reseeding starts the same sequence again
+    a.seed(42);
+    REQUIRE(a.get_seed() == 42);
+
+    for (auto const v : values) {
+        REQUIRE(bkrl::random::uniform_range(a, 0, 1000000) == v);
+    }
+}
+
+template <typename Generator>
+void check_snapshot() {
+    Generator gen {42};
+    gen.discard(1000);
+
+    for (int i = 0; i < 10; ++i) {
+        bkrl::random::uniform_range(gen, 0, 100);
+    }
+
+    auto const snapshot = gen.snapshot();
+    REQUIRE(snapshot.seed == 42);
+    REQUIRE(snapshot.count == gen.count());
+
+    std::vector<int> values;
+    for (int i = 0; i < 100; ++i) {
+        values.push_back(bkrl::random::uniform_range(gen, 0, 1000000));
+    }
+
+    //restoring into a generator with a different history
+    Generator other {7};
+    other();
+    other.restore(snapshot);
+
+    REQUIRE(other.get_seed() == 42);
+    REQUIRE(other.count() == snapshot.count);
+
+    for (auto const v : values) {
+        REQUIRE(bkrl::random::uniform_range(other, 0, 1000000) == v);
+    }
+
+    REQUIRE(other.count() == gen.count());
+}
+
+template <typename Generator>
+void check_helpers() {
+    Generator gen {7};
+
+    bkrl::random::random_dist dist;
+    dist.set_dice(3, 6, 1);
+
+    bkrl::random::random_dist normal;
+    normal.set_normal(10.0, 2.0, 0, 20);
+
+    for (int i = 0; i < 1000; ++i) {
+        auto const u = bkrl::random::uniform_range(gen, -5, 5);
+        REQUIRE(u >= -5);
+        REQUIRE(u <= 5);
+
+        auto const d = bkrl::random::roll_dice(gen, 2, 4, 0);
+        REQUIRE(d >= 2);
+        REQUIRE(d <= 8);
+
+        auto const r = dist(gen);
+        REQUIRE(r >= 4);
+        REQUIRE(r <= 19);
+
+        auto const n = normal(gen);
+        REQUIRE(n >= 0);
+        REQUIRE(n <= 20);
+    }
+}
+} //namespace
+
+TEST_CASE("generators are deterministic for a seed", "[random]") {
+    check_deterministic<bkrl::random::generator>();
+    check_deterministic<mt19937_generator>();
+    check_deterministic<xoshiro_generator>();
+}
+
+TEST_CASE("generators resume from a snapshot", "[random]") {
+    check_snapshot<bkrl::random::generator>();
+    check_snapshot<mt19937_generator>();
+    check_snapshot<xoshiro_generator>();
+    check_snapshot<bkrl::random::basic_generator<bkrl::random::philox4x32>>();
+
+    //a stream's state is just its key and position
+    using philox = bkrl::random::philox4x32;
+
+    auto gen = philox {1234}.derive(7);
+    gen.discard(5);
+    auto const state = gen.state();
+
+    auto const a = gen();
+    auto const b = gen();
+
+    philox other {0};
+    other();
+    other.restore(state);
+    REQUIRE(other.position() == 5);
+    REQUIRE(other() == a);
+    REQUIRE(other() == b);
+}
+
+TEST_CASE("random helpers work with every engine", "[random]") {
+    check_helpers<bkrl::random::generator>();
+    check_helpers<mt19937_generator>();
+    check_helpers<xoshiro_generator>();
+    check_helpers<bkrl::random::philox4x32>();
+}
+
+TEST_CASE("random_dist sample_all", "[random]") {
+    constexpr auto n = 100000;
+
+    bkrl::random::generator gen {99};
+    std::vector<int> out(n);
+
+    auto const mean = [&] {
+        auto sum = 0.0;
+        for (auto const v : out) {
+            sum += v;
+        }
+        return sum / n;
+    };
+
+    auto const in_range = [&](int const lo, int const hi) {
+        return std::all_of(std::begin(out), std::end(out), [&](int const v) {
+            return v >= lo && v <= hi;
+        });
+    };
+
+    bkrl::random::random_dist dist;
+
+    dist.set_constant(5);
+    dist.sample_all(gen, out);
+    REQUIRE(in_range(5, 5));
+
+    dist.set_uniform(-3, 7);
+    dist.sample_all(gen, out);
+    REQUIRE(in_range(-3, 7));
+    REQUIRE(mean() == Approx(2.0).epsilon(0.05));
+
+    //every face of every die shows up
+    dist.set_dice(3, 6, 2);
+    dist.sample_all(gen, out);
+    REQUIRE(in_range(5, 20));
+    REQUIRE(std::count(std::begin(out), std::end(out), 5)  > 0);
+    REQUIRE(std::count(std::begin(out), std::end(out), 20) > 0);
+    REQUIRE(mean() == Approx(3 * 3.5 + 2).epsilon(0.01));
+
+    //too many outcomes for a single roll
+    dist.set_dice(20, 20, 0);
+    dist.sample_all(gen, out);
+    REQUIRE(in_range(20, 400));
+    REQUIRE(mean() == Approx(20 * 10.5).epsilon(0.01));
+
+    dist.set_normal(10.0, 3.0, 0, 20);
+    dist.sample_all(gen, out);
+    REQUIRE(in_range(0, 20));
+    REQUIRE(mean() == Approx(10.0).epsilon(0.01));
+
+    //the same seed gives the same samples
+    std::vector<int> again(n);
+
+    dist.set_dice(4, 8, 0);
+    gen.seed(5);
+    dist.sample_all(gen, out);
+    gen.seed(5);
+    dist.sample_all(gen, again);
+    REQUIRE(out == again);
+
+    //any range of ints will do
+    int faces[16] {};
+    dist.set_dice(1, 4, 0);
+    dist.sample_all(gen, faces);
+    REQUIRE(std::all_of(std::begin(faces), std::end(faces), [](int const v) {
+        return v >= 1 && v <= 4;
+    }));
+}
+
+//------------------------------------------------------------------------------
+//! Compare sampling a distribution one value at a time and in bulk.
+//------------------------------------------------------------------------------
+TEST_CASE("random_dist sample_all benchmark", "[.][benchmark][random]") {
+    constexpr auto n = 1000000;
+
+    std::vector<int> out(n);
+
+    auto const run = [&](bkrl::random::random_dist const& dist, char const* one, char const* bulk) {
+        bkrl::random::generator gen {1234};
+
+        bkrl::stopwatch watch;
+        for (int i = 0; i < n; ++i) {
+            out[i] = dist(gen);
+        }
+        watch.report(one);
+
+        auto sink = std::accumulate(std::begin(out), std::end(out), int64_t {0});
+
+        watch.restart();
+        dist.sample_all(gen, out);
+        watch.report(bulk);
+
+        sink += std::accumulate(std::begin(out), std::end(out), int64_t {0});
+        return sink;
+    };
+
+    bkrl::random::random_dist uniform;
+    uniform.set_uniform(1, 100);
+
+    bkrl::random::random_dist dice;
+    dice.set_dice(3, 6, 0);
+
+    bkrl::random::random_dist normal;
+    normal.set_normal(20.0, 5.0, 1, 40);
+
+    auto sink = int64_t {0};
+    sink += run(uniform, "uniform operator(): ", "uniform sample_all: ");
+    sink += run(dice,    "3d6 operator():     ", "3d6 sample_all:     ");
+    sink += run(normal,  "normal operator():  ", "normal sample_all:  ");
+
+    REQUIRE(sink != 0);
+}
+
+//------------------------------------------------------------------------------
+//! Compare the throughput of the common helpers for each engine, and the cost
+//! of seeding a fresh generator (done per entity and per level).
+//------------------------------------------------------------------------------
+TEST_CASE("random engine benchmark", "[.][benchmark][random]") {
+    constexpr auto draws = 2000000;
+    constexpr auto seeds = 100000;
+
+    bkrl::random::random_dist dist;
+    dist.set_dice(3, 6, 0);
+
+    auto const run = [&](auto tag, char const* const engine) {
+        using generator_t = typename decltype(tag)::type;
+
+        generator_t gen {1234};
+        auto sink = int64_t {0};
+
+        bkrl::stopwatch watch;
+        for (int i = 0; i < draws; ++i) {
+            sink += bkrl::random::uniform_range(gen, 0, 99);
+        }
+        WARN(engine << "uniform_range: " << watch.elapsed_ms() << " ms");
+
+        watch.restart();
+        for (int i = 0; i < draws; ++i) {
+            sink += bkrl::random::roll_dice(gen, 3, 6, 0);
+        }
+        WARN(engine << "roll_dice:     " << watch.elapsed_ms() << " ms");
+
+        watch.restart();
+        for (int i = 0; i < draws; ++i) {
+            sink += dist(gen);
+        }
+        WARN(engine << "random_dist:   " << watch.elapsed_ms() << " ms");
+
+        watch.restart();
+        for (uint32_t i = 0; i < seeds; ++i) {
+            generator_t g {i};
+            sink += bkrl::random::uniform_range(g, 0, 1);
+        }
+        WARN(engine << "seed:          " << watch.elapsed_ms() << " ms");
+
+        return sink;
+    };
+
+    struct mt_tag      { using type = mt19937_generator; };
+    struct xoshiro_tag { using type = xoshiro_generator; };
+    struct philox_tag  { using type = bkrl::random::philox4x32; };
+
+    auto const a = run(mt_tag {},      "mt19937    ");
+    auto const b = run(xoshiro_tag {}, "xoshiro256 ");
+    auto const c = run(philox_tag {},  "philox4x32 ");
+
+    REQUIRE(a != 0);
+    REQUIRE(b != 0);
+    REQUIRE(c != 0);
+}
@@ -0,0 +1,336 @@
+#include "catch/catch.hpp"
+#include "scheduler.hpp"
+#include "random.hpp"
+#include "thread_pool.hpp"
+#include "benchmark.hpp"
+
+#include <vector>
+#include <map>
+#include <algorithm>
+
+using bkrl::scheduler;
+using bkrl::entity_id;
+
+TEST_CASE("scheduler basics", "[scheduler]") {
+    scheduler sched;
+
+    auto const id0 = entity_id {1};
+    auto const id1 = entity_id {2};
+
+    REQUIRE(sched.empty());
+
+    sched.insert(id0, scheduler::delay_for(scheduler::speed_normal));
+    sched.insert(id1, scheduler::delay_for(scheduler::speed_normal));
+
+    REQUIRE(sched.size() == 2);
+    REQUIRE(sched.is_scheduled(id0));
+    REQUIRE(*sched.next_time(id0) == scheduler::turn_length);
+
+    std::vector<entity_id> order;
+
+    auto const n = sched.advance(scheduler::turn_length, [&](entity_id const id) {
+        order.push_back(id);
+        return scheduler::delay_for(scheduler::speed_normal);
+    });
+
+    //ties are broken by the order of scheduling
+    REQUIRE(n == 2);
+    REQUIRE(order.size() == 2);
+    REQUIRE(order[0] == id0);
+    REQUIRE(order[1] == id1);
+    REQUIRE(sched.now() == scheduler::turn_length);
+
+    //nothing is due before a full turn has passed
+    REQUIRE(sched.advance(scheduler::turn_length / 2, [](entity_id) {
+        return scheduler::time_t {1};
+    }) == 0);
+}
+
+TEST_CASE("scheduler speed", "[scheduler]") {
+    scheduler sched;
+
+    auto const fast   = entity_id {1};
+    auto const normal = entity_id {2};
+    auto const slow   = entity_id {3};
+
+    std::map<uint32_t, bkrl::speed_t> speeds {
+        {id_to_value(fast),   200}
+      , {id_to_value(normal), 100}
+      , {id_to_value(slow),    50}
+    };
+
+    std::map<uint32_t, int> counts;
+
+    for (auto const& s : speeds) {
+        sched.insert(entity_id {s.first}, scheduler::delay_for(s.second));
+    }
+
+    for (int i = 0; i < 100; ++i) {
+        sched.advance(scheduler::turn_length, [&](entity_id const id) {
+            auto const value = id_to_value(id);
+            counts[value]++;
+            return scheduler::delay_for(speeds[value]);
+        });
+    }
+
+    REQUIRE(counts[id_to_value(fast)]   == 200);
+    REQUIRE(counts[id_to_value(normal)] == 100);
+    REQUIRE(counts[id_to_value(slow)]   == 50);
+}
+
+TEST_CASE("scheduler sleep and remove", "[scheduler]") {
+    scheduler sched;
+
+    auto const id0 = entity_id {1};
+    auto const id1 = entity_id {2};
+    auto const id2 = entity_id {3};
+
+    sched.insert(id0, 1);
+    sched.insert(id1, 2);
+    sched.insert(id2, 3);
+
+    REQUIRE(sched.remove(id2));
+    REQUIRE(!sched.remove(id2));
+    REQUIRE(!sched.is_scheduled(id2));
+
+    int acted = 0;
+
+    //id0 goes to sleep; id1 kills id0 (already asleep) and reschedules itself.
+    sched.advance(scheduler::turn_length, [&](entity_id const id) -> scheduler::time_t {
+        ++acted;
+
+        if (id == id0) {
+            return 0;
+        }
+
+        REQUIRE(id == id1);
+        REQUIRE(!sched.remove(id0));
+
+        sched.insert(id1, 1000);
+        return 1; //ignored; rescheduled explicitly above
+    });
+
+    REQUIRE(acted == 2);
+    REQUIRE(sched.size() == 1);
+    REQUIRE(*sched.next_time(id1) == 1002);
+
+    //sleeping entities can be woken up again.
+    sched.insert(id0, 1);
+    REQUIRE(sched.size() == 2);
+    REQUIRE(*sched.next_time(id0) == sched.now() + 1);
+}
+
+TEST_CASE("scheduler batched", "[scheduler]") {
+    scheduler sched_a;
+    scheduler sched_b;
+
+    std::vector<bkrl::speed_t> const speeds {100, 120, 150, 50, 100, 200};
+
+    for (uint32_t i = 0; i < speeds.size(); ++i) {
+        sched_a.insert(entity_id {i}, scheduler::delay_for(speeds[i]));
+        sched_b.insert(entity_id {i}, scheduler::delay_for(speeds[i]));
+    }
+
+    std::vector<entity_id> order_a;
+    std::vector<entity_id> order_b;
+
+    for (int t = 0; t < 50; ++t) {
+        auto const n_a = sched_a.advance(scheduler::turn_length, [&](entity_id const id) {
+            order_a.push_back(id);
+            return scheduler::delay_for(speeds[id_to_value(id)]);
+        });
+
+        auto const n_b = sched_b.advance_batched(scheduler::turn_length, [&](
+            std::vector<entity_id> const& ids
+          , std::vector<scheduler::time_t>& delays
+        ) {
+            REQUIRE(ids.size() == delays.size());
+
+            for (size_t i = 0; i < ids.size(); ++i) {
+                order_b.push_back(ids[i]);
+                delays[i] = scheduler::delay_for(speeds[id_to_value(ids[i])]);
+            }
+        });
+
+        REQUIRE(n_a == n_b);
+    }
+
+    //including those that come due more than once in a turn
+    REQUIRE(order_a == order_b);
+}
+
+//------------------------------------------------------------------------------
+//! Entities wandering about a small grid, as in level::advance; the outcome
+//! must be the same whatever the number of threads.
+//------------------------------------------------------------------------------
+TEST_CASE("scheduler parallel", "[scheduler][thread_pool]") {
+    constexpr int      size  = 32;
+    constexpr uint32_t count = 300;
+    constexpr uint32_t seed  = 1234;
+
+    using point_t = std::pair<int, int>;
+
+    auto const run = [&](unsigned const threads) {
+        bkrl::thread_pool pool {threads};
+        scheduler sched;
+
+        std::vector<point_t> positions(count);
+        std::vector<int>     occupied(size * size, 0);
+        std::vector<point_t> intents;
+
+        for (uint32_t i = 0; i < count; ++i) {
+            auto const p = point_t {static_cast<int>(i) % size, static_cast<int>(i) / size};
+            positions[i] = p;
+            occupied[p.second * size + p.first] = 1;
+
+            sched.insert(entity_id {i}, scheduler::delay_for(static_cast<bkrl::speed_t>(50 + i % 4 * 50)));
+        }
+
+        for (int t = 0; t < 100; ++t) {
+            sched.advance_parallel(scheduler::turn_length, pool, 16, intents
+              , [&](entity_id const id, scheduler::time_t const time) {
+                    auto gen = bkrl::random::philox4x32 {seed}.derive(time).derive(id_to_value(id));
+                    auto const v = bkrl::random::direction(gen);
+                    return point_t {v.x, v.y};
+                }
+              , [&](entity_id const id, point_t const& v) {
+                    auto const i = id_to_value(id);
+                    auto&      p = positions[i];
+                    auto const x = p.first  + v.first;
+                    auto const y = p.second + v.second;
+
+                    if (x >= 0 && x < size && y >= 0 && y < size && !occupied[y * size + x]) {
+                        occupied[p.second * size + p.first] = 0;
+                        occupied[y * size + x] = 1;
+                        p = point_t {x, y};
+                    }
+
+                    return scheduler::delay_for(static_cast<bkrl::speed_t>(50 + i % 4 * 50));
+                }
+            );
+        }
+
+        return positions;
+    };
+
+    auto const p1 = run(1);
+    auto const p4 = run(4);
+    auto const p7 = run(7);
+
+    REQUIRE(p1 == p4);
+    REQUIRE(p1 == p7);
+
+    //and they actually went somewhere
+    auto moved = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        if (p1[i] != point_t {static_cast<int>(i) % size, static_cast<int>(i) / size}) {
+            ++moved;
+        }
+    }
+
+    REQUIRE(moved > 0);
+}
+
+//------------------------------------------------------------------------------
+//! Compare the scheduler against updating (or polling) every entity every turn
+//! for a level of 10k entities, most of which are idle.
+//------------------------------------------------------------------------------
+TEST_CASE("scheduler benchmark", "[.][benchmark][scheduler]") {
+    constexpr auto entity_count = 10000;
+    constexpr auto active_count = 500;
+    constexpr auto idle_turns   = 50;
+    constexpr auto turns        = 1000;
+
+    //stands in for the work done by an entity when it acts: a couple of rolls
+    //and a lookup for whatever occupies the tile it wants to move to.
+    bkrl::random::generator gen {1234};
+
+    std::vector<uint32_t> occupied(entity_count);
+    for (uint32_t i = 0; i < entity_count; ++i) {
+        occupied[i] = i * 7;
+    }
+
+    auto sink = uint64_t {0};
+    auto const act = [&](uint32_t const id) {
+        if (bkrl::random::percent(gen) < 25) {
+            return;
+        }
+
+        auto const v = bkrl::random::direction(gen);
+        auto const p = static_cast<uint32_t>(id * 7 + v.x + v.y * 3);
+
+        sink += *std::lower_bound(std::begin(occupied), std::end(occupied) - 1, p);
+    };
+
+    auto const delay = [&](uint32_t const id) {
+        return (id < active_count)
+          ? scheduler::delay_for(scheduler::speed_normal)
+          : scheduler::delay_for(scheduler::speed_normal, idle_turns);
+    };
+
+    //
+    // every entity, every turn
+    //
+    {
+        auto acted = size_t {0};
+        bkrl::stopwatch watch;
+        for (int t = 1; t <= turns; ++t) {
+            for (uint32_t i = 0; i < entity_count; ++i) {
+                act(i);
+                ++acted;
+            }
+        }
+        WARN("update all: " << watch.elapsed_ms() << " ms; " << acted << " entities acted");
+    }
+
+    //
+    // poll every entity, every turn for those that are due
+    //
+    {
+        std::vector<scheduler::time_t> next(entity_count);
+        for (uint32_t i = 0; i < entity_count; ++i) {
+            next[i] = delay(i);
+        }
+
+        auto acted = size_t {0};
+        bkrl::stopwatch watch;
+        for (int t = 1; t <= turns; ++t) {
+            auto const now = static_cast<scheduler::time_t>(t) * scheduler::turn_length;
+            for (uint32_t i = 0; i < entity_count; ++i) {
+                if (next[i] > now) {
+                    continue;
+                }
+
+                act(i);
+                next[i] = now + delay(i);
+                ++acted;
+            }
+        }
+        WARN("poll due:   " << watch.elapsed_ms() << " ms; " << acted << " entities acted");
+    }
+
+    //
+    // scheduled
+    //
+    {
+        scheduler sched;
+        for (uint32_t i = 0; i < entity_count; ++i) {
+            sched.insert(entity_id {i}, delay(i));
+        }
+
+        auto acted = size_t {0};
+        bkrl::stopwatch watch;
+        for (int t = 1; t <= turns; ++t) {
+            acted += sched.advance(scheduler::turn_length, [&](entity_id const id) {
+                auto const i = id_to_value(id);
+                act(i);
+                return delay(i);
+            });
+        }
+        WARN("scheduled:  " << watch.elapsed_ms() << " ms; " << acted << " entities acted");
+
+        REQUIRE(acted < static_cast<size_t>(entity_count) * turns);
+    }
+
+    REQUIRE(sink != 0);
+}
@@ -0,0 +1,194 @@
+#include "catch/catch.hpp"
+
+#include "spawn_table.hpp"
+#include "entity.hpp"
+#include "json.hpp"
+#include "random.hpp"
+#include "benchmark.hpp"
+
+#include <vector>
+
+namespace {
+
+char const test_entity_defs[] = R"(
+{ "file_type": "ENTITY"
+, "file_name": "./data/entities.bmp"
+, "tile_size": [18, 18]
+, "player" : [13, 13]
+, "definitions": [
+    {"id": "RAT",      "tile": [0, 0], "color": [0, 0, 0], "health": ["dice", 1, 4]}
+  , {"id": "SKELETON", "tile": [0, 0], "color": [0, 0, 0], "health": ["dice", 1, 4]}
+  , {"id": "GOLEM",    "tile": [0, 0], "color": [0, 0, 0], "health": ["dice", 1, 4]}
+  ]
+}
+)";
+
+char const test_spawn_defs[] = R"(
+{ "file_type": "SPAWN"
+, "definitions": [
+    { "id": "ROOM_TEST"
+    , "spawns": [
+        [3, "RAT",      0, 1]
+      , [1, "SKELETON", 1]
+      , [1, "GOLEM",    4]
+      ]
+    }
+  , { "id": "ROOM_DEEP"
+    , "spawns": [[1, "GOLEM", 2, 2]]
+    }
+  , { "id": "ROOM_ABYSS"
+    , "spawns": [[1, "RAT", 0, 60000], [1, "GOLEM", 50000, 65534]]
+    }
+  ]
+}
+)";
+
+struct spawn_test_data {
+    spawn_test_data() {
+        entity_defs.load_definitions(bkrl::json::common::from_memory(test_entity_defs));
+        spawn_defs.load_definitions(bkrl::json::common::from_memory(test_spawn_defs));
+        spawn_defs.link(entity_defs);
+    }
+
+    bkrl::entity_def_index index(char const* const id) const {
+        return entity_defs.index_of(bkrl::entity_def_id {bkrl::slash_hash32(id)});
+    }
+
+    bkrl::spawn_table const& table(char const* const id) const {
+        return spawn_defs[bkrl::spawn_table_def_id {bkrl::slash_hash32(id)}];
+    }
+
+    //! the number of times each entity is spawned at depth in n tries.
+    std::vector<int> counts(bkrl::spawn_table const& t, int const depth, int const n) {
+        std::vector<int> result(static_cast<size_t>(entity_defs.get_definitions_size()));
+
+        for (int i = 0; i < n; ++i) {
+            auto const def = t(gen, depth);
+            REQUIRE(!!def);
+            ++result[bkrl::id_to_value(*def)];
+        }
+
+        return result;
+    }
+
+    bkrl::entity_definitions      entity_defs;
+    bkrl::spawn_table_definitions spawn_defs;
+    bkrl::random_t                gen {1234};
+};
+
+} //namespace
+
+TEST_CASE("spawn tables by depth", "[spawn]") {
+    spawn_test_data data;
+
+    REQUIRE(data.spawn_defs.size() == 3);
+    REQUIRE(data.spawn_defs.find(bkrl::spawn_table_def_id {bkrl::slash_hash32("ROOM_NONE")}) == nullptr);
+
+    auto const& table = data.table("ROOM_TEST");
+    REQUIRE(table.is_linked());
+
+    //0, 1, 2 to 3 and 4 on differ; everything deeper is the same as 4
+    REQUIRE(table.depth_count() == 4);
+
+    auto const rat      = bkrl::id_to_value(data.index("RAT"));
+    auto const skeleton = bkrl::id_to_value(data.index("SKELETON"));
+    auto const golem    = bkrl::id_to_value(data.index("GOLEM"));
+
+    constexpr auto n = 10000;
+
+    SECTION("only the rules for a depth apply") {
+        auto const d0 = data.counts(table, 0, n);
+        REQUIRE(d0[rat] == n);
+
+        auto const d2 = data.counts(table, 2, n);
+        REQUIRE(d2[skeleton] == n);
+
+        auto const d9 = data.counts(table, 9, n);
+        REQUIRE(d9[rat] == 0);
+        REQUIRE(d9[skeleton] > 0);
+        REQUIRE(d9[golem] > 0);
+    }
+
+    SECTION("entities are chosen by weight") {
+        auto const d1 = data.counts(table, 1, n);
+        REQUIRE(d1[golem] == 0);
+
+        auto const rat_ratio = static_cast<double>(d1[rat]) / n;
+        REQUIRE(rat_ratio == Approx(0.75).epsilon(0.05));
+    }
+
+    SECTION("nothing spawns where no rule applies") {
+        auto const& deep = data.table("ROOM_DEEP");
+
+        REQUIRE(!deep(data.gen, 0));
+        REQUIRE(!deep(data.gen, 1));
+        REQUIRE(bkrl::id_to_value(*deep(data.gen, 2)) == golem);
+        REQUIRE(!deep(data.gen, 3));
+        REQUIRE(!deep(data.gen, 100));
+    }
+
+    SECTION("deep rules only cost a table per run of depths") {
+        auto const& abyss = data.table("ROOM_ABYSS");
+
+        //0 to 49999, 50000 to 60000, 60001 to 65534 and 65535 on
+        REQUIRE(abyss.depth_count() == 4);
+
+        REQUIRE(bkrl::id_to_value(*abyss(data.gen, 49999)) == rat);
+        REQUIRE(bkrl::id_to_value(*abyss(data.gen, 65534)) == golem);
+        REQUIRE(!abyss(data.gen, 65535));
+        REQUIRE(!abyss(data.gen, 100000));
+
+        auto const both = data.counts(abyss, 55000, n);
+        REQUIRE(both[rat] > 0);
+        REQUIRE(both[golem] > 0);
+    }
+}
+
+//------------------------------------------------------------------------------
+//! Compare choosing an entity from a spawn table against scanning the rules
+//! for the depth and rolling against their total weight each time.
+//------------------------------------------------------------------------------
+TEST_CASE("spawn table benchmark", "[.][benchmark][spawn]") {
+    constexpr auto n     = 2000000;
+    constexpr auto depth = 6;
+
+    spawn_test_data data;
+    auto const& table = data.table("ROOM_TEST");
+
+    std::vector<bkrl::spawn_rule_t> rules;
+    table.for_each_rule([&](bkrl::spawn_rule_t const& rule) {
+        rules.push_back(rule);
+    });
+
+    auto sink = uint64_t {0};
+
+    bkrl::stopwatch watch;
+    for (int i = 0; i < n; ++i) {
+        auto total = 0;
+        for (auto const& rule : rules) {
+            if (depth >= rule.depth_lo && depth <= rule.depth_hi) {
+                total += rule.weight;
+            }
+        }
+
+        auto roll = bkrl::random::uniform_range(data.gen, 0, total - 1);
+        for (auto const& rule : rules) {
+            if (depth < rule.depth_lo || depth > rule.depth_hi) {
+                continue;
+            }
+
+            if ((roll -= rule.weight) < 0) {
+                sink += bkrl::id_to_value(rule.id);
+                break;
+            }
+        }
+    }
+    watch.report("scan rules:  ");
+
+    for (int i = 0; i < n; ++i) {
+        sink += bkrl::id_to_value(*table(data.gen, depth));
+    }
+    watch.report("spawn_table: ");
+
+    REQUIRE(sink != 0);
+}
@@ -0,0 +1,117 @@
+#include "catch/catch.hpp"
+#include "thread_pool.hpp"
+#include "random.hpp"
+#include "benchmark.hpp"
+
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <vector>
+
+using bkrl::thread_pool;
+
+TEST_CASE("thread_pool basics", "[thread_pool]") {
+    thread_pool pool {4};
+
+    REQUIRE(pool.size() == 4);
+
+    SECTION("empty") {
+        auto called = false;
+        pool.parallel_for(0, 1, [&](size_t, size_t) { called = true; });
+        REQUIRE(!called);
+    }
+
+    SECTION("every index exactly once") {
+        constexpr size_t n = 10007;
+
+        std::vector<std::atomic<int>> counts(n);
+        std::atomic<bool> bad_range {false};
+
+        //catch isn't thread safe; check the results afterwards
+        for (int i = 0; i < 10; ++i) {
+            pool.parallel_for(n, 16, [&](size_t const first, size_t const last) {
+                if (first >= last || last > n) {
+                    bad_range = true;
+                }
+
+                for (auto j = first; j < last; ++j) {
+                    counts[j]++;
+                }
+            });
+        }
+
+        REQUIRE(!bad_range);
+
+        for (auto const& c : counts) {
+            REQUIRE(c == 10);
+        }
+    }
+
+    SECTION("small jobs run on the caller") {
+        auto const id = std::this_thread::get_id();
+
+        pool.parallel_for(8, 16, [&](size_t const first, size_t const last) {
+            REQUIRE(first == 0);
+            REQUIRE(last  == 8);
+            REQUIRE(std::this_thread::get_id() == id);
+        });
+    }
+}
+
+TEST_CASE("thread_pool derived streams are deterministic", "[thread_pool][random]") {
+    constexpr size_t   n    = 2000;
+    constexpr uint32_t seed = 12345;
+
+    auto const run = [&](unsigned const threads) {
+        thread_pool pool {threads};
+        std::vector<int> result(n);
+
+        pool.parallel_for(n, 1, [&](size_t const first, size_t const last) {
+            for (auto i = first; i < last; ++i) {
+                bkrl::random::generator gen {bkrl::random::derive_seed(seed, i)};
+                result[i] = bkrl::random::percent(gen);
+            }
+        });
+
+        return result;
+    };
+
+    auto const r1 = run(1);
+    auto const r4 = run(4);
+    auto const r7 = run(7);
+
+    REQUIRE(r1 == r4);
+    REQUIRE(r1 == r7);
+
+    //and the streams actually differ
+    REQUIRE(bkrl::random::derive_seed(seed, 0) != bkrl::random::derive_seed(seed, 1));
+    REQUIRE(bkrl::random::derive_seed(seed, 0) != bkrl::random::derive_seed(seed + 1, 0));
+}
+
+//------------------------------------------------------------------------------
+//! Scaling of a decide-like workload (seed a stream, make a few rolls) over
+//! the number of threads.
+//------------------------------------------------------------------------------
+TEST_CASE("thread_pool benchmark", "[.][benchmark][thread_pool]") {
+    constexpr size_t n      = 5000;
+    constexpr int    rounds = 20;
+
+    std::vector<int> result(n);
+
+    auto const hw = std::max(1u, std::thread::hardware_concurrency());
+
+    for (unsigned threads = 1; threads <= hw; threads *= 2) {
+        thread_pool pool {threads};
+
+        bkrl::stopwatch watch;
+        for (int r = 0; r < rounds; ++r) {
+            pool.parallel_for(n, 64, [&](size_t const first, size_t const last) {
+                for (auto i = first; i < last; ++i) {
+                    bkrl::random::generator gen {bkrl::random::derive_seed(r, i)};
+                    result[i] = bkrl::random::percent(gen) + bkrl::random::direction(gen).x;
+                }
+            });
+        }
+        WARN(threads << " threads: " << watch.elapsed_ms(rounds) << " ms per round");
+    }
+}
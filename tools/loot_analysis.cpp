@@ -0,0 +1,308 @@
+//##############################################################################
+//! @file
+//! @author Brandon Kentel
+//!
+//! Monte Carlo analysis of loot tables for balancing.
+//!
+//! usage: loot_analysis [options] [file]
+//!   file              the loot definitions to load; defaults to data/loot.def
+//!   --table ID        only analyse the table ID; defaults to every table
+//!   --iterations N    the number of times each table is rolled
+//!   --threads N       the number of threads to use; 0 uses one per core
+//!   --seed N          the seed the per thread streams are derived from
+//!
+//! The exact expected quantity of each item is reported alongside the sampled
+//! one as a check.
+//!
+//! Each thread rolls its own share of the iterations with a generator seeded
+//! from (seed, table, thread), and the per thread results are combined in
+//! thread order, so the output only depends on the seed and thread count.
+//##############################################################################
+#include "loot_table.hpp"
+#include "thread_pool.hpp"
+#include "random.hpp"
+#include "json.hpp"
+#include "hash.hpp"
+
+#include <boost/container/flat_map.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace {
+
+using bkrl::hash_t;
+
+template <typename K, typename V>
+using map_t = boost::container::flat_map<K, V>;
+
+//==============================================================================
+//! Statistics for the quantity of a single item generated by each roll.
+//==============================================================================
+struct item_stats_t {
+    uint64_t sum     = 0; //!< the total quantity over every roll.
+    uint64_t sum_sq  = 0; //!< the sum of the squared quantity of each roll.
+    uint64_t hits    = 0; //!< the number of rolls generating any of the item.
+    uint32_t min_hit = std::numeric_limits<uint32_t>::max(); //!< ignoring misses.
+    uint32_t max     = 0;
+
+    void add(uint32_t const n) noexcept {
+        sum     += n;
+        sum_sq  += static_cast<uint64_t>(n) * n;
+        hits    += 1;
+        min_hit  = std::min(min_hit, n);
+        max      = std::max(max, n);
+    }
+
+    void merge(item_stats_t const& other) noexcept {
+        sum     += other.sum;
+        sum_sq  += other.sum_sq;
+        hits    += other.hits;
+        min_hit  = std::min(min_hit, other.min_hit);
+        max      = std::max(max, other.max);
+    }
+};
+
+//==============================================================================
+//! The results of rolling one table some number of times.
+//==============================================================================
+class table_stats {
+public:
+    //--------------------------------------------------------------------------
+    void roll(
+        bkrl::random_t&                     gen
+      , bkrl::loot_table_definitions const& defs
+      , bkrl::loot_table             const& table
+      , uint64_t                      const n
+    ) {
+        for (uint64_t i = 0; i < n; ++i) {
+            roll_counts_.clear();
+
+            table.generate(gen, defs, [&](bkrl::item_def_id const id, uint16_t const count) {
+                roll_counts_[bkrl::id_to_value(id)] += count;
+            });
+
+            if (roll_counts_.empty()) {
+                ++empty_;
+            }
+
+            for (auto const& c : roll_counts_) {
+                items_[c.first].add(c.second);
+            }
+        }
+
+        rolls_ += n;
+    }
+
+    //--------------------------------------------------------------------------
+    void merge(table_stats const& other) {
+        for (auto const& item : other.items_) {
+            items_[item.first].merge(item.second);
+        }
+
+        rolls_ += other.rolls_;
+        empty_ += other.empty_;
+    }
+
+    uint64_t rolls() const noexcept { return rolls_; }
+    uint64_t empty() const noexcept { return empty_; }
+
+    map_t<hash_t, item_stats_t> const& items() const noexcept { return items_; }
+private:
+    map_t<hash_t, item_stats_t> items_;
+    map_t<hash_t, uint32_t>     roll_counts_; //!< scratch for the current roll.
+
+    uint64_t rolls_ = 0;
+    uint64_t empty_ = 0;
+};
+
+//==============================================================================
+struct options_t {
+    bkrl::path_string file       = BK_PATH_LITERAL("data/loot.def");
+    std::string       table;
+    uint64_t          iterations = 1000000;
+    unsigned          threads    = 0;
+    uint32_t          seed       = 0;
+};
+
+//------------------------------------------------------------------------------
+void print_usage() {
+    std::fprintf(stderr,
+        "usage: loot_analysis [--table ID] [--iterations N] [--threads N] [--seed N] [file]\n");
+}
+
+//------------------------------------------------------------------------------
+bool parse_options(int const argc, char** const argv, options_t& out) {
+    for (int i = 1; i < argc; ++i) {
+        auto const arg = argv[i];
+
+        if (arg[0] != '-') {
+            out.file.assign(arg, arg + std::strlen(arg));
+            continue;
+        }
+
+        if (i + 1 >= argc) {
+            return false;
+        }
+
+        auto const value = argv[++i];
+
+        char* end = nullptr;
+        auto const n = std::strtoull(value, &end, 10);
+        auto const is_number = *value && !*end;
+
+        if (std::strcmp(arg, "--table") == 0) {
+            out.table = value;
+        } else if (std::strcmp(arg, "--iterations") == 0 && is_number && n) {
+            out.iterations = n;
+        } else if (std::strcmp(arg, "--threads") == 0 && is_number) {
+            out.threads = static_cast<unsigned>(n);
+        } else if (std::strcmp(arg, "--seed") == 0 && is_number) {
+            out.seed = static_cast<uint32_t>(n);
+        } else {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+//! The names of every item referred to by any of the tables, for reporting.
+//------------------------------------------------------------------------------
+map_t<hash_t, std::string> item_names(bkrl::loot_table_definitions const& defs) {
+    map_t<hash_t, std::string> result;
+
+    for (int i = 0; i < defs.size(); ++i) {
+        auto const index = bkrl::loot_table_def_index {static_cast<uint16_t>(i)};
+
+        defs[index].for_each_rule([&](bkrl::loot_rule_data_t const& rule) {
+            if (rule.id_type == bkrl::loot_rule_data_t::id_t::item_ref) {
+                result.emplace(rule.id, rule.id_debug_string.data());
+            }
+        });
+    }
+
+    return result;
+}
+
+//------------------------------------------------------------------------------
+table_stats analyse(
+    bkrl::thread_pool&                  pool
+  , bkrl::loot_table_definitions const& defs
+  , bkrl::loot_table_def_index    const index
+  , options_t                     const& options
+) {
+    auto const streams = static_cast<size_t>(pool.size());
+    auto const n       = options.iterations;
+    auto const& table  = defs[index];
+
+    std::vector<table_stats> results(streams);
+
+    //one stream per chunk; which thread runs it doesn't matter.
+    pool.parallel_for(streams, 1, [&](size_t const first, size_t const last) {
+        for (auto i = first; i < last; ++i) {
+            auto const key  = (static_cast<uint64_t>(bkrl::id_to_value(index)) << 32) | i;
+            auto const seed = bkrl::random::derive_seed(options.seed, key);
+
+            bkrl::random_t gen {seed};
+
+            auto const share = n / streams + ((i < n % streams) ? 1 : 0);
+            results[i].roll(gen, defs, table, share);
+        }
+    });
+
+    table_stats result;
+    for (auto const& r : results) {
+        result.merge(r);
+    }
+
+    return result;
+}
+
+//------------------------------------------------------------------------------
+void report(
+    bkrl::loot_table_definitions      const& defs
+  , bkrl::loot_table                  const& table
+  , table_stats                       const& stats
+  , map_t<hash_t, std::string>        const& names
+) {
+    map_t<hash_t, double> exact;
+    for (auto const& e : table.expected_counts(defs)) {
+        exact.emplace(bkrl::id_to_value(e.id), e.count);
+    }
+
+    auto const rolls = static_cast<double>(stats.rolls());
+
+    std::printf("%s: %llu rolls, %.4f%% empty\n"
+      , table.id_string().to_string().c_str()
+      , static_cast<unsigned long long>(stats.rolls())
+      , 100.0 * static_cast<double>(stats.empty()) / rolls
+    );
+
+    std::printf("  %-30s %12s %12s %12s %6s %6s\n"
+      , "item", "expected", "exact", "variance", "min", "max");
+
+    for (auto const& item : stats.items()) {
+        auto const& s = item.second;
+
+        auto const it   = names.find(item.first);
+        auto const name = (it != std::end(names)) ? it->second : std::to_string(item.first);
+
+        auto const mean     = static_cast<double>(s.sum) / rolls;
+        auto const variance = static_cast<double>(s.sum_sq) / rolls - mean * mean;
+        auto const min      = (s.hits < stats.rolls()) ? 0u : s.min_hit;
+
+        std::printf("  %-30s %12.6f %12.6f %12.6f %6u %6u\n"
+          , name.c_str(), mean, exact[item.first], variance, min, s.max);
+    }
+
+    std::printf("\n");
+}
+
+} //namespace
+
+//------------------------------------------------------------------------------
+int main(int const argc, char** const argv) {
+    options_t options;
+    if (!parse_options(argc, argv, options)) {
+        print_usage();
+        return EXIT_FAILURE;
+    }
+
+    bkrl::loot_table_definitions defs;
+    defs.load_definitions(bkrl::json::common::from_file(options.file));
+    defs.link();
+
+    auto const names = item_names(defs);
+
+    bkrl::thread_pool pool {options.threads};
+
+    std::printf("seed %u, %u threads\n\n", options.seed, pool.size());
+
+    auto const table_id = bkrl::slash_hash32(options.table);
+    auto found = false;
+
+    for (int i = 0; i < defs.size(); ++i) {
+        auto const  index = bkrl::loot_table_def_index {static_cast<uint16_t>(i)};
+        auto const& table = defs[index];
+
+        if (!options.table.empty() && bkrl::id_to_value(table.id()) != table_id) {
+            continue;
+        }
+
+        found = true;
+        report(defs, table, analyse(pool, defs, index, options), names);
+    }
+
+    if (!found) {
+        std::fprintf(stderr, "no table named %s\n", options.table.c_str());
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}